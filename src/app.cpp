@@ -18,6 +18,7 @@
  */
 
 #include <cctype>
+#include <climits>
 #include <cstdlib>
 #include <exception>
 #include <iostream>
@@ -33,8 +34,10 @@
 #include "appinfo.h"
 #include "hexdameview.h"
 #include "hexdamegame.h"
+#include "perft.h"
 #include "player.h"
 #include "player/heuristic.h"
+#include "transpositiontable.h"
 
 namespace
 {
@@ -207,17 +210,143 @@ App::App(int &argc, char **argv)
                 LOG4CXX_WARN(_logger, "Option \"" << arg << "\" already specified. Ignoring.");
             }
             _interactive = true;
+        } else if (matches_option(arg, "perft")) {
+            // Verify that there is another argument
+            if ((idx + 1) >= argc) {
+                LOG4CXX_FATAL(_logger, "Option \"" << arg << "\" requires a parameter.");
+                std::exit(1);
+            }
+
+            // Increment the index
+            idx++;
+
+            // Get the depth
+            bool ok;
+            _perftDepth = QString(argv[idx]).toInt(&ok);
+            if (!ok || _perftDepth < 1) {
+                LOG4CXX_FATAL(_logger, "Invalid perft depth: \"" << argv[idx] << "\".");
+                std::exit(1);
+            }
+        } else if (matches_option(arg, "radius")) {
+            // Verify that there is another argument
+            if ((idx + 1) >= argc) {
+                LOG4CXX_FATAL(_logger, "Option \"" << arg << "\" requires a parameter.");
+                std::exit(1);
+            }
+
+            // Increment the index
+            idx++;
+
+            // Get the size of the grid
+            bool ok;
+            _perftRadius = QString(argv[idx]).toInt(&ok);
+            if (!ok || _perftRadius < 4 || _perftRadius > 6) {
+                LOG4CXX_FATAL(_logger, "Invalid radius: \"" << argv[idx] << "\", expected 4, 5 or 6.");
+                std::exit(1);
+            }
+        } else if (matches_option(arg, "rules")) {
+            // Verify that there is another argument
+            if ((idx + 1) >= argc) {
+                LOG4CXX_FATAL(_logger, "Option \"" << arg << "\" requires a parameter.");
+                std::exit(1);
+            }
+
+            // Increment the index
+            idx++;
+
+            // Get the variant, it is checked when it is used
+            _perftRules = QString(argv[idx]).toLower();
+        } else if (matches_option(arg, "divide")) {
+            _perftDivide = true;
+        } else if (matches_option(arg, "no-bulk")) {
+            _perftBulk = false;
+        } else if (matches_option(arg, "cross-check")) {
+            _perftCheck = true;
+        } else if (matches_option(arg, "position")) {
+            // Verify that there is another argument
+            if ((idx + 1) >= argc) {
+                LOG4CXX_FATAL(_logger, "Option \"" << arg << "\" requires a parameter.");
+                std::exit(1);
+            }
+
+            // Increment the index
+            idx++;
+
+            // Get the position, it is checked when it is used
+            _position = argv[idx];
+        } else if (matches_option(arg, "hash")) {
+            // Verify that there is another argument
+            if ((idx + 1) >= argc) {
+                LOG4CXX_FATAL(_logger, "Option \"" << arg << "\" requires a parameter.");
+                std::exit(1);
+            }
+
+            // Increment the index
+            idx++;
+
+            // Get the size in megabytes
+            bool ok;
+            _hashSize = QString(argv[idx]).toInt(&ok);
+            if (!ok || _hashSize < 0) {
+                LOG4CXX_FATAL(_logger, "Invalid hash size: \"" << argv[idx] << "\".");
+                std::exit(1);
+            }
+        } else if (matches_option(arg, "threads")) {
+            // Verify that there is another argument
+            if ((idx + 1) >= argc) {
+                LOG4CXX_FATAL(_logger, "Option \"" << arg << "\" requires a parameter.");
+                std::exit(1);
+            }
+
+            // Increment the index
+            idx++;
+
+            // Get the number of threads
+            bool ok;
+            _threads = QString(argv[idx]).toInt(&ok);
+            if (!ok || _threads < 1) {
+                LOG4CXX_FATAL(_logger, "Invalid number of threads: \"" << argv[idx] << "\".");
+                std::exit(1);
+            }
+        } else if (matches_option(arg, "scaling")) {
+            // Verify that there is another argument
+            if ((idx + 1) >= argc) {
+                LOG4CXX_FATAL(_logger, "Option \"" << arg << "\" requires a parameter.");
+                std::exit(1);
+            }
+
+            // Increment the index
+            idx++;
+
+            // Get the depth
+            bool ok;
+            _scalingDepth = QString(argv[idx]).toInt(&ok);
+            if (!ok || _scalingDepth < 1 || _scalingDepth > MTDfPlayer::MAX_DEPTH) {
+                LOG4CXX_FATAL(_logger, "Invalid search depth: \"" << argv[idx] << "\".");
+                std::exit(1);
+            }
         } else {
             LOG4CXX_WARN(_logger, "Unrecognized option: \"" << arg << "\". Ignoring");
         }
         idx++;
     }
 
+    if (_perftDepth > 0) {
+        std::exit(perftMain());
+    }
+    if (_scalingDepth > 0) {
+        std::exit(scalingMain());
+    }
+
     initGUI();
 }
 
 App::~App()
 {
+    // the players search in the table until they are gone
+    delete _game;
+    _game = 0;
+    delete _ttable;
 }
 
 App *
@@ -246,9 +375,112 @@ App::initGUI()
     // Display the main window
     _mainwindow->setVisible(true);
 
+    // the engines of every game share one table, kept in a file if asked to
+    QSettings settings;
+    _ttable = new TranspositionTable(settings.value("search/hash", 64).toInt(),
+                                     settings.value("search/hashfile").toString());
+
     newGame();
 }
 
+int
+App::perftMain()
+{
+    // the variants are only built for the standard grid
+    if (_perftRules != "standard" && _perftRadius != 4) {
+        LOG4CXX_FATAL(_logger, "Rule variants are only available with radius 4.");
+        return 1;
+    }
+
+    if (_perftRules == "free-capture") return perftMain<4, FreeCaptureRules>();
+    if (_perftRules == "short-kings") return perftMain<4, ShortKingRules>();
+    if (_perftRules == "forward-capture") return perftMain<4, ForwardCaptureRules>();
+    if (_perftRules != "standard") {
+        LOG4CXX_FATAL(_logger, "Unrecognized rules: \"" << _perftRules << "\".");
+        return 1;
+    }
+
+    switch (_perftRadius) {
+        case 5: return perftMain<5, StandardRules>();
+        case 6: return perftMain<6, StandardRules>();
+        default: return perftMain<4, StandardRules>();
+    }
+}
+
+template<int Radius, class Rules>
+int
+App::perftMain()
+{
+    BasicHexdameGrid<Radius, Rules> grid;
+    Color turn = White;
+    if (!_position.isEmpty() && !BasicHexdameGrid<Radius, Rules>::fromString(_position, grid, turn)) {
+        LOG4CXX_FATAL(_logger, "Invalid position: \"" << _position << "\".");
+        return 1;
+    }
+
+    BasicPerft<Radius, Rules> perft(grid, turn);
+    perft.setBulkCounting(_perftBulk);
+    perft.setHashSize(_hashSize);
+    perft.setThreads(_threads);
+    perft.setCrossCheck(_perftCheck);
+
+    std::cout << grid.toString(turn) << std::endl;
+
+    QTime tic;
+    tic.start();
+    quint64 nodes = perft.run(_perftDepth);
+    int msecs = tic.elapsed();
+
+    if (_perftDivide) {
+        const typename BasicPerft<Radius, Rules>::MoveList &moves = perft.rootMoves();
+        for (int i = 0; i < moves.size(); ++i) {
+            std::cout << BasicPerft<Radius, Rules>::toString(moves[i]) << " " << perft.rootCount(i) << std::endl;
+        }
+    }
+    std::cout << "Nodes: " << nodes << std::endl;
+    std::cout << "Time: " << msecs << " ms" << std::endl;
+    std::cout << "Nodes/sec: " << nodes * 1000 / qMax(msecs, 1) << std::endl;
+    if (_perftCheck) {
+        std::cout << "Errors: " << perft.errors() << std::endl;
+    }
+
+    return perft.errors() ? 1 : 0;
+}
+
+int
+App::scalingMain()
+{
+    HexdameGrid grid;
+    Color turn = White;
+    if (!_position.isEmpty() && !HexdameGrid::fromString(_position, grid, turn)) {
+        LOG4CXX_FATAL(_logger, "Invalid position: \"" << _position << "\".");
+        return 1;
+    }
+
+    std::cout << grid.toString(turn) << std::endl;
+    std::cout << "Threads  Time (ms)  Nodes  Speedup" << std::endl;
+
+    TranspositionTable table(_hashSize > 0 ? _hashSize : 64);
+    int single = 0;
+    for (int threads = 1; threads <= qMax(_threads, 1); ++threads) {
+        // every run starts cold, the table would hand the depth to the next
+        table.clear();
+        MTDfPlayer player(0, turn, new SomeHeuristic(), &table);
+        player.setThreads(threads);
+
+        QTime tic;
+        tic.start();
+        player.search(grid, PositionHistory(grid.zobristHash()), _scalingDepth, INT_MAX);
+        int msecs = qMax(tic.elapsed(), 1);
+        if (threads == 1) single = msecs;
+
+        std::cout << threads << "  " << msecs << "  " << player.nodes() << "  "
+                  << double(single) / msecs << std::endl;
+    }
+
+    return 0;
+}
+
 void
 App::loadActions()
 {
@@ -331,10 +563,10 @@ App::setBlackPlayer(int idx)
             _game->setBlackPlayer(new NegaMaxPlayer(_game, Black, new SomeHeuristic()));
             break;
         case 3:
-            _game->setBlackPlayer(new NegaMaxPlayerWTt(_game, Black, new SomeHeuristic()));
+            _game->setBlackPlayer(new NegaMaxPlayerWTt(_game, Black, new SomeHeuristic(), _ttable));
             break;
         case 4:
-            _game->setBlackPlayer(new MTDfPlayer(_game, Black, new SomeHeuristic()));
+            _game->setBlackPlayer(newMTDfPlayer(Black));
             break;
     }
 }
@@ -355,14 +587,23 @@ App::setWhitePlayer(int idx)
             _game->setWhitePlayer(new NegaMaxPlayer(_game, White, new SomeHeuristic()));
             break;
         case 3:
-            _game->setWhitePlayer(new NegaMaxPlayerWTt(_game, White, new SomeHeuristic()));
+            _game->setWhitePlayer(new NegaMaxPlayerWTt(_game, White, new SomeHeuristic(), _ttable));
             break;
         case 4:
-            _game->setWhitePlayer(new MTDfPlayer(_game, White, new SomeHeuristic()));
+            _game->setWhitePlayer(newMTDfPlayer(White));
             break;
     }
 }
 
+MTDfPlayer *
+App::newMTDfPlayer(Color color)
+{
+    MTDfPlayer *player = new MTDfPlayer(_game, color, new SomeHeuristic(), _ttable);
+    // --threads takes precedence over the preference
+    if (_threads > 0) player->setThreads(_threads);
+    return player;
+}
+
 void
 App::setDebugMode(bool debug)
 {
@@ -387,6 +628,18 @@ App::printHelpMessage()
     std::cout << "    --loglevel <logger>=<level>  Sets the logging level for the given logger." << std::endl;
     std::cout << "    --gui                        Run in graphical user interface mode." << std::endl;
     std::cout << "    --interactive                Run in interactive commandline mode." << std::endl;
+    std::cout << "    --perft <depth>              Counts the leaves <depth> plies ahead and exits." << std::endl;
+    std::cout << "    --divide                     Prints the perft count below each move." << std::endl;
+    std::cout << "    --no-bulk                    Makes the moves of the last perft ply too." << std::endl;
+    std::cout << "    --cross-check                Checks the move generator on every perft node." << std::endl;
+    std::cout << "    --position <position>        Starts from the given position instead." << std::endl;
+    std::cout << "    --radius <4|5|6>             Runs perft on a grid of 61, 91 or 127 cells." << std::endl;
+    std::cout << "    --rules <variant>            Runs perft with the standard, free-capture," << std::endl;
+    std::cout << "                                 short-kings or forward-capture rules." << std::endl;
+    std::cout << "    --hash <megabytes>           Size of the perft or scaling hash table." << std::endl;
+    std::cout << "    --threads <n>                Number of threads to use." << std::endl;
+    std::cout << "    --scaling <depth>            Times an MTD(f) search to <depth> with 1 to" << std::endl;
+    std::cout << "                                 --threads threads and exits." << std::endl;
     std::cout << "Log Levels:" << std::endl;
     std::cout << "    all" << std::endl;
     std::cout << "    trace" << std::endl;
@@ -25,8 +25,12 @@
 #include <QtGui>
 #include <log4cxx/logger.h>
 
+#include "commondefs.h"
+
 class HexdameGame;
 class HexdameView;
+class MTDfPlayer;
+class TranspositionTable;
 
 class App : public QApplication
 {
@@ -58,6 +62,12 @@ public slots:
 
 private:
     void initGUI();
+    MTDfPlayer *newMTDfPlayer(Color color);
+    // counts the leaves below _position, returns the exit code
+    int perftMain();
+    template<int Radius, class Rules> int perftMain();
+    // times a fixed depth search of _position with more and more threads
+    int scalingMain();
     void interactiveMain();
     void consoleMain();
     void loadActions();
@@ -83,8 +93,19 @@ private:
     QString _invocation;
     bool _gui;
     bool _interactive;
+    int _perftDepth = 0;
+    int _perftRadius = 4;
+    QString _perftRules = "standard";
+    bool _perftDivide = false;
+    bool _perftBulk = true;
+    bool _perftCheck = false;
+    int _hashSize = 0;
+    int _threads = 0;  // 0 if not given
+    int _scalingDepth = 0;
+    QString _position;
     std::shared_ptr<QMainWindow> _mainwindow;
     HexdameGame *_game = 0;
+    TranspositionTable *_ttable = 0;
     HexdameView *_gameView = 0;
     QComboBox *_blackCombo = 0;
     QComboBox *_whiteCombo = 0;
@@ -0,0 +1,251 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "batchgenerator.h"
+
+#include "gridtables.h"
+#include "player/heuristic.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEXDAME_AVX2
+#endif
+
+namespace {
+
+constexpr GridTables tables = GridTables::make();
+
+// LANES words handled as one, the compiler turns the operators into AVX2
+// instructions inside functions built for it
+const int LANES = BatchGenerator::LANES;
+typedef quint64 Lanes __attribute__((vector_size(LANES * sizeof(quint64))));
+
+// the code below is written once for a single word and for Lanes, it has to
+// be inlined into the function picking the instruction set, which also
+// makes the ABI of passing Lanes around irrelevant
+#define BATCH_INLINE inline __attribute__((always_inline))
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+BATCH_INLINE quint64 popcount(quint64 w) { return BitOps::popcount(w); }
+
+BATCH_INLINE Lanes
+popcount(const Lanes &v)
+{
+    // no popcount instruction for 64 bit lanes before AVX-512
+    Lanes w = v - ((v >> 1) & Q_UINT64_C(0x5555555555555555));
+    w = (w & Q_UINT64_C(0x3333333333333333)) + ((w >> 2) & Q_UINT64_C(0x3333333333333333));
+    w = (w + (w >> 4)) & Q_UINT64_C(0x0f0f0f0f0f0f0f0f);
+    w = w + (w >> 8);
+    w = w + (w >> 16);
+    w = w + (w >> 32);
+    return w & 0x7f;
+}
+
+BATCH_INLINE bool none(quint64 w) { return !w; }
+
+BATCH_INLINE bool
+none(const Lanes &w)
+{
+    quint64 any = 0;
+    for (int l = 0; l < LANES; ++l) {
+        any |= w[l];
+    }
+    return !any;
+}
+
+// HexdameGrid::shift on every word of w
+template<class W>
+BATCH_INLINE W
+shift(const W &w, int d)
+{
+    W shifted = W();
+    for (int i = 0; i < tables.shiftCount[d]; ++i) {
+        const int n = tables.shifts[d][i].amount;
+        const W part = w & tables.shifts[d][i].from.word();
+        shifted |= n >= 0 ? part << n : part >> -n;
+    }
+    return shifted;
+}
+
+/**
+ * Movers, destinations, capturers and material without the special cases of
+ * a side with no pieces left, for the standard rules: pawns capture backwards
+ * and kings fly. whiteToMove has all bits set where White is to move.
+ */
+template<class W>
+BATCH_INLINE void
+kernel(const W &white, const W &black, const W &kings, const W &whiteToMove,
+       W &movers, W *destinations, W &capturers, W &material)
+{
+    const W own = (white & whiteToMove) | (black & ~whiteToMove);
+    const W opp = (white | black) & ~own;
+    const W empty = ~(white | black);
+
+    // a piece can step in direction d if its neighbour there is empty
+    W open[6];
+    for (int d = 0; d < 6; ++d) {
+        open[d] = shift(empty, 5 - d);
+    }
+    const W north = open[0] | open[1] | open[2];
+    const W south = open[3] | open[4] | open[5];
+    const W forward = (north & whiteToMove) | (south & ~whiteToMove);
+    movers = (own & ~kings & forward) | (own & kings & (north | south));
+
+    // pawns step forward, kings fly as far as the cells are empty
+    const bool noKings = none(own & kings);
+    for (int d = 0; d < 6; ++d) {
+        const W ahead = d <= 2 ? whiteToMove : ~whiteToMove;
+        destinations[d] = shift(own & ~kings & ahead & open[d], d);
+        if (noKings) continue;
+
+        W ray = shift(own & kings & open[d], d);
+        for (int i = 0; i < GridTables::SIZE - 1 && !none(ray); ++i) {
+            destinations[d] |= ray;
+            ray = shift(ray, d) & empty;
+        }
+    }
+
+    capturers = W();
+    for (int d = 0; d < 6; ++d) {
+        const int back = 5 - d;
+        // cells next to an opponent that can be jumped over in direction d
+        W reach = shift(opp & open[d], back);
+        capturers |= own & reach;
+        if (noKings) continue;
+
+        // kings also from further away, over empty cells
+        W ray = reach;
+        for (int i = 0; i < GridTables::SIZE - 3 && !none(ray); ++i) {
+            ray = shift(ray & empty, back);
+            reach |= ray;
+        }
+        capturers |= own & kings & reach;
+    }
+
+    material = popcount(own) + 2 * popcount(own & kings)
+             - popcount(opp) - 2 * popcount(opp & kings);
+}
+
+// writes what kernel found for position i to out, a side without pieces
+// left has won or lost whatever its material
+void
+store(const BatchGenerator::Positions &in, int i, quint64 movers, const quint64 *destinations,
+      quint64 capturers, quint64 material, const BatchGenerator::Results &out)
+{
+    const quint64 own = in.turn[i] == White ? in.white[i] : in.black[i];
+    const quint64 opp = in.turn[i] == White ? in.black[i] : in.white[i];
+    out.movers[i] = movers;
+    for (int d = 0; d < 6; ++d) {
+        out.destinations[6 * i + d] = destinations[d];
+    }
+    out.capturers[i] = capturers;
+    if (!opp) out.material[i] = AbstractHeuristic::WIN;
+    else if (!own) out.material[i] = -AbstractHeuristic::WIN;
+    else out.material[i] = int(qint64(material));
+}
+
+void
+scalar(const BatchGenerator::Positions &in, int begin, int end, const BatchGenerator::Results &out)
+{
+    for (int i = begin; i < end; ++i) {
+        quint64 movers, destinations[6], capturers, material;
+        kernel<quint64>(in.white[i], in.black[i], in.kings[i], in.turn[i] == White ? ~Q_UINT64_C(0) : 0,
+                        movers, destinations, capturers, material);
+        store(in, i, movers, destinations, capturers, material, out);
+    }
+}
+
+#ifdef HEXDAME_AVX2
+__attribute__((target("avx2"))) void
+avx2(const BatchGenerator::Positions &in, int count, const BatchGenerator::Results &out)
+{
+    int i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        Lanes white, black, kings, whiteToMove;
+        for (int l = 0; l < LANES; ++l) {
+            white[l] = in.white[i+l];
+            black[l] = in.black[i+l];
+            kings[l] = in.kings[i+l];
+            whiteToMove[l] = in.turn[i+l] == White ? ~Q_UINT64_C(0) : 0;
+        }
+
+        Lanes movers, destinations[6], capturers, material;
+        kernel<Lanes>(white, black, kings, whiteToMove, movers, destinations, capturers, material);
+        for (int l = 0; l < LANES; ++l) {
+            const quint64 lane[6] = { destinations[0][l], destinations[1][l], destinations[2][l],
+                                      destinations[3][l], destinations[4][l], destinations[5][l] };
+            store(in, i + l, movers[l], lane, capturers[l], material[l], out);
+        }
+    }
+    scalar(in, i, count, out);
+}
+#endif
+
+}
+
+void
+BatchGenerator::run(const Positions &in, int count, const Results &out)
+{
+#ifdef HEXDAME_AVX2
+    if (vectorized()) {
+        avx2(in, count, out);
+        return;
+    }
+#endif
+    scalar(in, 0, count, out);
+}
+
+void
+BatchGenerator::runScalar(const Positions &in, int count, const Results &out)
+{
+    scalar(in, 0, count, out);
+}
+
+void
+BatchGenerator::quietMoves(const Positions &in, const Results &out, int i, MoveList &moves)
+{
+    moves.clear();
+    const quint64 own = in.turn[i] == White ? in.white[i] : in.black[i];
+    for (int d = 0; d < 6; ++d) {
+        quint64 to = out.destinations[6 * i + d];
+        while (to) {
+            const int idx = BitOps::lsb(to);
+            to &= to - 1;
+
+            // back along d over the empty cells to the piece that came
+            quint64 from = Q_UINT64_C(1) << idx;
+            do {
+                from = shift(from, 5 - d);
+            } while (from && !(from & own));
+            Q_ASSERT(from);
+            moves << MoveBit(BitOps::lsb(from), idx);
+        }
+    }
+}
+
+bool
+BatchGenerator::vectorized()
+{
+#ifdef HEXDAME_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
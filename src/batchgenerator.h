@@ -0,0 +1,78 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef BATCHGENERATOR_H
+#define BATCHGENERATOR_H
+
+#include "commondefs.h"
+#include "movelist.h"
+
+/**
+ * Moves and material of many independent positions of the standard game at
+ * once, for labelling and perft like jobs going through millions of them.
+ *
+ * Positions come as arrays of boards, one word per position, so that LANES
+ * of them fill an AVX2 register. Rather than lists of moves, whose length
+ * differs from one position to the next, it finds the cells the quiet moves
+ * go to in each direction and the pieces that can capture, with a few dozen
+ * whole board operations and no branch per position; quietMoves turns the
+ * boards of one position into moves. Captures are still left to
+ * MoveGenerator. Uses AVX2 where the processor has it and single words
+ * otherwise, both give the same results.
+ */
+class BatchGenerator
+{
+public:
+    // positions handled at once by run, it takes any count and does the
+    // last ones one at a time
+    static const int LANES = 4;
+
+    // entry i of every array belongs to position i
+    struct Positions {
+        const quint64 *white;
+        const quint64 *black;
+        const quint64 *kings;
+        const qint8 *turn;  // White or Black
+    };
+    struct Results {
+        // pieces of the side to move that can step or fly to an empty cell,
+        // whether or not a capture is mandatory
+        quint64 *movers;
+        // 6 per position, entry 6 * i + d has the cells its pieces reach in
+        // direction d without capturing: one step for pawns, any distance
+        // for kings
+        quint64 *destinations;
+        // the same as HexdameGrid::capturingPieces
+        quint64 *capturers;
+        // the same as SomeHeuristic::value
+        int *material;
+    };
+
+    // fills the first count entries of out
+    static void run(const Positions &in, int count, const Results &out);
+    // the same one position at a time, whatever the processor
+    static void runScalar(const Positions &in, int count, const Results &out);
+    // the quiet moves of position i after run, the same as
+    // MoveGenerator::validQuietMoves in another order
+    static void quietMoves(const Positions &in, const Results &out, int i, MoveList &moves);
+
+    // whether run uses AVX2
+    static bool vectorized();
+};
+
+#endif // BATCHGENERATOR_H
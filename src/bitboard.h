@@ -0,0 +1,132 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+
+#include <type_traits>
+
+typedef unsigned __int128 quint128;
+
+// bit tricks on the words a BasicBitBoard may be made of
+namespace BitOps {
+inline int popcount(quint64 w) { return __builtin_popcountll(w); }
+inline int popcount(quint128 w) { return popcount(quint64(w)) + popcount(quint64(w >> 64)); }
+// index of the lowest/highest set bit, undefined for 0
+inline int lsb(quint64 w) { return __builtin_ctzll(w); }
+inline int lsb(quint128 w) { return quint64(w) ? lsb(quint64(w)) : 64 + lsb(quint64(w >> 64)); }
+inline int msb(quint64 w) { return 63 - __builtin_clzll(w); }
+inline int msb(quint128 w) { return quint64(w >> 64) ? 64 + msb(quint64(w >> 64)) : msb(quint64(w)); }
+// 64 bits made of all the bits of w, for hashing
+constexpr quint64 fold(quint64 w) { return w; }
+constexpr quint64 fold(quint128 w) { return quint64(w) ^ quint64(w >> 64); }
+}
+
+/**
+ * One bit per cell of the grid, backed by a single 64 bit word, or a 128 bit
+ * one for grids of more than 64 cells.
+ *
+ * The interface mirrors the subset of std::bitset we used to rely on, plus
+ * popcount/bit-scan helpers and an iterator over the set bits so hot loops
+ * don't have to test all cells one by one.
+ */
+template<int Cells>
+class BasicBitBoard
+{
+public:
+    static_assert(Cells > 0 && Cells <= 128, "at most 128 cells fit in a bitboard");
+    typedef typename std::conditional<(Cells <= 64), quint64, quint128>::type Word;
+
+    static const int SIZE = Cells;
+    static constexpr Word MASK = ~Word(0) >> (8 * sizeof(Word) - Cells);
+
+    // iterates over the indices of the set bits, lowest first
+    class iterator
+    {
+    public:
+        constexpr explicit iterator(Word bits) : _bits(bits) { }
+        int operator*() const { return BitOps::lsb(_bits); }
+        iterator &operator++() { _bits &= _bits - 1; return *this; }
+        constexpr bool operator!=(const iterator &other) const { return _bits != other._bits; }
+        constexpr bool operator==(const iterator &other) const { return _bits == other._bits; }
+
+    private:
+        Word _bits;
+    };
+    typedef iterator const_iterator;
+
+    constexpr BasicBitBoard() : _bits(0) { }
+    constexpr BasicBitBoard(Word bits) : _bits(bits & MASK) { }
+
+    static constexpr BasicBitBoard square(int idx) { return BasicBitBoard(Word(1) << idx); }
+
+    constexpr bool test(int idx) const { return (_bits >> idx) & 1; }
+    constexpr bool operator[](int idx) const { return test(idx); }
+
+    constexpr BasicBitBoard &set(int idx) { _bits |= Word(1) << idx; return *this; }
+    constexpr BasicBitBoard &reset(int idx) { _bits &= ~(Word(1) << idx); return *this; }
+    constexpr BasicBitBoard &reset() { _bits = 0; return *this; }
+    constexpr BasicBitBoard &flip(int idx) { _bits ^= Word(1) << idx; return *this; }
+
+    int count() const { return BitOps::popcount(_bits); }
+    constexpr bool any() const { return _bits != 0; }
+    constexpr bool none() const { return _bits == 0; }
+    constexpr Word word() const { return _bits; }
+
+    // index of the lowest/highest set bit, undefined if none() is true
+    int first() const { return BitOps::lsb(_bits); }
+    int last() const { return BitOps::msb(_bits); }
+    // clears the lowest set bit and returns its index
+    int popFirst() { int idx = first(); _bits &= _bits - 1; return idx; }
+
+    iterator begin() const { return iterator(_bits); }
+    iterator end() const { return iterator(0); }
+
+    constexpr bool operator==(const BasicBitBoard &other) const { return _bits == other._bits; }
+    constexpr bool operator!=(const BasicBitBoard &other) const { return _bits != other._bits; }
+
+    constexpr BasicBitBoard operator~() const { return BasicBitBoard(~_bits); }
+    constexpr BasicBitBoard operator&(const BasicBitBoard &other) const { return BasicBitBoard(_bits & other._bits); }
+    constexpr BasicBitBoard operator|(const BasicBitBoard &other) const { return BasicBitBoard(_bits | other._bits); }
+    constexpr BasicBitBoard operator^(const BasicBitBoard &other) const { return BasicBitBoard(_bits ^ other._bits); }
+    constexpr BasicBitBoard operator<<(int n) const { return BasicBitBoard(_bits << n); }
+    constexpr BasicBitBoard operator>>(int n) const { return BasicBitBoard(_bits >> n); }
+
+    constexpr BasicBitBoard &operator&=(const BasicBitBoard &other) { _bits &= other._bits; return *this; }
+    constexpr BasicBitBoard &operator|=(const BasicBitBoard &other) { _bits |= other._bits; return *this; }
+    constexpr BasicBitBoard &operator^=(const BasicBitBoard &other) { _bits ^= other._bits; return *this; }
+    constexpr BasicBitBoard &operator<<=(int n) { _bits = (_bits << n) & MASK; return *this; }
+    constexpr BasicBitBoard &operator>>=(int n) { _bits >>= n; return *this; }
+
+    // shifts towards higher indices for n > 0 and lower indices for n < 0
+    constexpr BasicBitBoard shifted(int n) const { return n >= 0 ? *this << n : *this >> -n; }
+
+private:
+    Word _bits;
+};
+
+template<int Cells>
+constexpr typename BasicBitBoard<Cells>::Word BasicBitBoard<Cells>::MASK;
+
+// the standard 61 cell board
+typedef BasicBitBoard<61> BitBoard;
+
+#endif // BITBOARD_H
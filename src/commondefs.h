@@ -20,14 +20,12 @@
 #ifndef COMMONDEFS_H
 #define COMMONDEFS_H
 
-#include <bitset>
+#include "bitboard.h"
 
 #include <QList>
 #include <QSet>
 #include <QMetaType>
 
-typedef std::bitset<61> BitBoard;
-
 class QDebug;
 
 enum Piece {
@@ -95,28 +93,50 @@ struct Move {
 };
 Q_DECLARE_METATYPE(Move)
 
-struct MoveBit {
-    BitBoard path;
-    BitBoard taken;
-
-    MoveBit() { }
-    MoveBit(const MoveBit &other)
-        : path(other.path)
-        , taken(other.taken) { }
-    MoveBit & operator=(const MoveBit &other) {
-        if (this != &other) {
-            path = other.path;
-            taken = other.taken;
-        }
-        return *this;
-    }
-    inline bool empty() const { return (path | taken).none(); }
-    bool operator==(const MoveBit &m) const {
-        return path == m.path && taken == m.taken;
-    }
-
-    friend QDebug operator<<(QDebug dbg, const MoveBit &move);
+/**
+ * A move as the search sees it: the cell the piece starts from, the one it
+ * ends on and the pieces it takes on the way.
+ *
+ * Packed into 10 bytes on the standard board to keep move lists and
+ * transposition table entries small. A default constructed move is empty,
+ * no real move starts and ends on the same cell.
+ */
+#pragma pack(push, 2)
+template<class BB>
+struct BasicMoveBit {
+    typedef BB BitBoard;
+
+    BasicMoveBit() : _taken(0), _squares(0) { }
+    BasicMoveBit(int from, int to, const BitBoard &taken = BitBoard())
+        : _taken(taken.word()), _squares(from | to << SHIFT) { }
+
+    inline int from() const { return _squares & ((1 << SHIFT) - 1); }
+    inline int   to() const { return _squares >> SHIFT; }
+    inline BitBoard  path() const { return empty() ? BitBoard() : BitBoard::square(from()) | BitBoard::square(to()); }
+    inline BitBoard taken() const { return BitBoard(_taken); }
+    // from and to in 12 bits (14 beyond 64 cells), to index killer or history tables
+    inline quint16 squares() const { return _squares; }
+
+    inline bool empty() const { return _squares == 0; }
+    inline bool isCapture() const { return _taken != 0; }
+    bool operator==(const BasicMoveBit &m) const { return _squares == m._squares && _taken == m._taken; }
+    bool operator!=(const BasicMoveBit &m) const { return !(*this == m); }
+
+    friend uint qHash(const BasicMoveBit &m) { return qHash(BitOps::fold(m._taken) ^ (quint64(m._squares) << 51)); }
+
+private:
+    // bits needed for a cell index
+    static const int SHIFT = BitBoard::SIZE > 64 ? 7 : 6;
+
+    typename BitBoard::Word _taken;
+    quint16 _squares;
 };
+#pragma pack(pop)
+
+typedef BasicMoveBit<BitBoard> MoveBit;
+static_assert(sizeof(MoveBit) == 10, "MoveBit should be packed");
 Q_DECLARE_METATYPE(MoveBit)
 
+QDebug operator<<(QDebug dbg, const MoveBit &move);
+
 #endif // COMMONDEFS_H
@@ -0,0 +1,158 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRIDTABLES_H
+#define GRIDTABLES_H
+
+#include "bitboard.h"
+
+/**
+ * Geometry of a grid with Radius cells from the centre to each side and the
+ * Zobrist keys, computed at compile time.
+ *
+ * Cells are numbered over x then y, skipping the corners of the SIZE x SIZE
+ * square with |x - y| > Radius that aren't part of the hexagon. Directions
+ * are numbered like BasicHexdameGrid::Direction.
+ */
+template<int Radius>
+struct BasicGridTables {
+    static const int SIZE = 2 * Radius + 1;
+    static const int CELLS = 3 * Radius * (Radius + 1) + 1;
+    typedef BasicBitBoard<CELLS> BitBoard;
+
+    // cell index of (x, y), -1 if it isn't on the grid
+    qint8 coordToIdx[SIZE][SIZE];
+    quint8 idxToCoord[CELLS][2];
+
+    BitBoard neighbourMasks[CELLS];
+    BitBoard northMasks[CELLS];
+    BitBoard southMasks[CELLS];
+    BitBoard pawnJumpMasks[CELLS][6];
+    BitBoard kingJumpMasks[CELLS][6];
+    // every cell from idx to the edge of the grid in one direction
+    BitBoard rayMasks[CELLS][6];
+    // the far side, where pawns become kings
+    BitBoard whitePromotion;
+    BitBoard blackPromotion;
+
+    // cells whose neighbour in one direction lies amount indices away
+    struct Shift {
+        int amount;
+        BitBoard from;
+    };
+    Shift shifts[6][SIZE];
+    int shiftCount[6];
+
+    quint64 zobrist[CELLS][4];
+    quint64 zobristTurn;
+
+    constexpr int index(int x, int y) const {
+        return x < 0 || y < 0 || x >= SIZE || y >= SIZE ? -1 : coordToIdx[x][y];
+    }
+
+    static constexpr BasicGridTables make();
+
+private:
+    // splitmix64, good enough for Zobrist keys and usable at compile time
+    static constexpr quint64 random(quint64 &state) {
+        state += Q_UINT64_C(0x9e3779b97f4a7c15);
+        quint64 z = state;
+        z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+        z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+        return z ^ (z >> 31);
+    }
+};
+
+template<int Radius>
+constexpr BasicGridTables<Radius>
+BasicGridTables<Radius>::make()
+{
+    BasicGridTables t{};
+
+    int cells = 0;
+    for (int x = 0; x < SIZE; ++x) {
+        for (int y = 0; y < SIZE; ++y) {
+            if (x - y > Radius || y - x > Radius) {
+                t.coordToIdx[x][y] = -1;
+                continue;
+            }
+            t.coordToIdx[x][y] = cells;
+            t.idxToCoord[cells][0] = x;
+            t.idxToCoord[cells][1] = y;
+            if (x == SIZE - 1 || y == SIZE - 1) t.whitePromotion.set(cells);
+            if (x == 0 || y == 0) t.blackPromotion.set(cells);
+            ++cells;
+        }
+    }
+
+    // don't change order:  |NorthWest|  North  |NorthEast|SouthEast|  South  |SouthWest|
+    const int dx[6] = {        1,        1,        0,        0,       -1,       -1    };
+    const int dy[6] = {        0,        1,        1,       -1,       -1,        0    };
+    for (int idx = 0; idx < CELLS; ++idx) {
+        const int x = t.idxToCoord[idx][0];
+        const int y = t.idxToCoord[idx][1];
+        for (int d = 0; d < 6; ++d) {
+            const int one = t.index(x + dx[d], y + dy[d]);
+            if (one < 0) continue; // not on the grid
+
+            if (d < 3) { // going north
+                t.northMasks[idx].set(one);
+            } else { // going south
+                t.southMasks[idx].set(one);
+            }
+
+            // group cells by the index offset of their neighbour
+            const int amount = one - idx;
+            int i = 0;
+            while (i < t.shiftCount[d] && t.shifts[d][i].amount != amount) ++i;
+            if (i == t.shiftCount[d]) {
+                t.shifts[d][i].amount = amount;
+                t.shiftCount[d]++;
+            }
+            t.shifts[d][i].from.set(idx);
+
+            for (int n = 1; t.index(x + n*dx[d], y + n*dy[d]) >= 0; ++n) {
+                t.rayMasks[idx][d].set(t.index(x + n*dx[d], y + n*dy[d]));
+            }
+
+            const int two = t.index(x + 2*dx[d], y + 2*dy[d]);
+            if (two < 0) continue; // not on the grid
+
+            t.neighbourMasks[idx].set(one);
+            t.pawnJumpMasks[idx][d].set(one).set(two);
+            t.kingJumpMasks[idx][d] = t.rayMasks[idx][d];
+        }
+    }
+
+    // fixed seed, hashes are the same in every run
+    quint64 seed = Q_UINT64_C(0x48657864616d65); // "Hexdame"
+    for (int idx = 0; idx < CELLS; ++idx) {
+        for (int j = 0; j < 4; ++j) {
+            t.zobrist[idx][j] = random(seed);
+        }
+    }
+    t.zobristTurn = random(seed);
+
+    return t;
+}
+
+// the standard board, 9 cells across
+typedef BasicGridTables<4> GridTables;
+
+#endif // GRIDTABLES_H
@@ -26,9 +26,9 @@
 
 HexdameGame::HexdameGame(QObject *parent)
     : QObject(parent)
+    , _history(_grid.zobristHash())
 {
     connect(this, SIGNAL(playerMoved()), SLOT(startNextTurn()));
-    qRegisterMetaType<Move>("Move");
     qRegisterMetaType<MoveBit>("MoveBit");
 }
 
@@ -52,9 +52,53 @@ HexdameGame::debugRightClick(Coord c)
     }
     // this will compute all moves
     setDebugMode(true);
+    _history.reset(_grid.zobristHash());
     emit boardChanged();
 }
 
+QList<QPair<MoveBit, Move>>
+HexdameGame::movesFrom(const Coord &c) const
+{
+    QList<QPair<MoveBit, Move>> moves;
+    if (!_partial.empty() && c != _partial.to()) return moves;
+
+    const HexdameGrid start = _partial.empty() ? _grid : HexdameGrid(_turnStart);
+    const Coord from = _partial.empty() ? c : _partial.from();
+    const int steps = _partial.taken.size();
+
+    MoveList valid;
+    start.computeValidMoveBits(currentColor(), valid);
+    for (int i = 0; i < valid.size(); ++i) {
+        const MoveBit &m = valid.at(i);
+        if (m.from() != HexdameGrid::index(from)) continue;
+
+        foreach (Move path, start.movePaths(m)) {
+            // has to go through the steps already made
+            if (!_partial.empty()) {
+                if (path.path.mid(0, steps + 1) != _partial.path) continue;
+                if (path.taken.mid(0, steps) != _partial.taken) continue;
+            }
+
+            path.path = path.path.mid(steps);
+            path.taken = path.taken.mid(steps);
+            moves << qMakePair(m, path);
+            break;
+        }
+    }
+    return moves;
+}
+
+QList<Move>
+HexdameGame::validMoves(const Coord &c) const
+{
+    QList<Move> moves;
+    typedef QPair<MoveBit, Move> Pair;
+    foreach (const Pair &m, movesFrom(c)) {
+        moves << m.second;
+    }
+    return moves;
+}
+
 void
 HexdameGame::makeMove(const Coord &from, const Coord &to)
 {
@@ -62,14 +106,25 @@ HexdameGame::makeMove(const Coord &from, const Coord &to)
 
     if (debug()) {
         _grid.move(from, to);
+        _history.reset(_grid.zobristHash());
 
         emit boardChanged();
 
         return;
     }
 
-    Move move = _grid.computeValidMoves(currentColor()).value(from).value(to);
-    makeMove(move);
+    typedef QPair<MoveBit, Move> Pair;
+    foreach (const Pair &m, movesFrom(from)) {
+        if (m.second.to() != to) continue;
+
+        // undo the steps shown so far, the move contains them
+        if (!_partial.empty()) {
+            _grid = HexdameGrid(_turnStart);
+            _partial = Move();
+        }
+        makeMove(m.first);
+        return;
+    }
 }
 
 void
@@ -77,23 +132,13 @@ HexdameGame::makeMove(const MoveBit &move)
 {
     if (move.empty()) return;
 
+    const bool irreversible = move.isCapture() || _grid.isPawn(move.from());
     _grid.makeMoveBit(move);
+    _history.push(_grid.zobristHash(), irreversible);
     emit boardChanged();
     emit playerMoved();
 }
 
-void
-HexdameGame::makeMove(const Move &move, bool partial)
-{
-    if (move.empty()) return;
-
-    _grid.makeMove(move, partial);
-    emit boardChanged();
-    if (!partial)
-        emit playerMoved();
-}
-
-
 void
 HexdameGame::makePartialMove(const Coord &from, const Coord &to)
 {
@@ -101,48 +146,46 @@ HexdameGame::makePartialMove(const Coord &from, const Coord &to)
 
     if (debug()) {
         _grid.move(from, to);
+        _history.reset(_grid.zobristHash());
 
         emit boardChanged();
 
         return;
     }
 
-    QMultiHash<Coord, Move> tmpHash = _grid.computeValidMoves(currentColor()).value(from);
-    Move m;
-    foreach (Move move, tmpHash.values()) {
-        // not a partial moves
-        if (move.to() == to) continue;
-
-        m = Move();
+    // the steps up to to of the move getting there the soonest
+    Move step;
+    typedef QPair<MoveBit, Move> Pair;
+    foreach (const Pair &m, movesFrom(from)) {
+        int i = m.second.path.indexOf(to);
+        if (i <= 0 || i == m.second.path.size() - 1) continue;
+        if (!step.empty() && i >= step.path.size() - 1) continue;
 
-        m.path << move.path.takeFirst();
-
-        while (!move.path.empty() && move.path.first() != to) {
-            m.path << move.path.takeFirst();
-            m.taken << move.taken.takeFirst();
-        }
+        step.path = m.second.path.mid(0, i + 1);
+        step.taken = m.second.taken.mid(0, i);
+    }
+    if (step.empty()) return;
 
-        if (!move.path.empty()) {
-            m.path << move.path.first();
-            m.taken << move.taken.first();
-            break;
-        }
+    if (_partial.empty()) {
+        _turnStart = _grid.position();
+        _partial.path << from;
     }
+    _partial.path << step.path.mid(1);
+    _partial.taken << step.taken;
 
-    makeMove(m, true);
+    _grid.makeMove(step, true);
+    emit boardChanged();
 }
 
 void
 HexdameGame::setBlackPlayer(AbstractPlayer *player)
 {
     if (_black) {
-        disconnect(_black, SIGNAL(move(Move)), this, SLOT(makeMove(Move)));
         disconnect(_black, SIGNAL(moveBit(MoveBit)), this, SLOT(makeMove(MoveBit)));
         _black->deleteLater();
     }
     _black = player;
     if (_black) {
-        connect(_black, SIGNAL(move(Move)), this, SLOT(makeMove(Move)));
         connect(_black, SIGNAL(moveBit(MoveBit)), this, SLOT(makeMove(MoveBit)));
     }
     if (currentColor() == Black)
@@ -153,13 +196,11 @@ void
 HexdameGame::setWhitePlayer(AbstractPlayer *player)
 {
     if (_white) {
-        disconnect(_white, SIGNAL(move(Move)), this, SLOT(makeMove(Move)));
         disconnect(_white, SIGNAL(moveBit(MoveBit)), this, SLOT(makeMove(MoveBit)));
         _white->deleteLater();
     }
     _white = player;
     if (_white) {
-        connect(_white, SIGNAL(move(Move)), this, SLOT(makeMove(Move)));
         connect(_white, SIGNAL(moveBit(MoveBit)), this, SLOT(makeMove(MoveBit)));
     }
     if (currentColor() == White)
@@ -169,15 +210,14 @@ HexdameGame::setWhitePlayer(AbstractPlayer *player)
 void
 HexdameGame::startNextTurn()
 {
-    if (_grid.winner() == None) {
-        if (_currentColor == White) {
-            _currentColor = Black;
-        } else {
-            _currentColor = White;
-        }
-
-        currentPlayer()->start();
+    const Color next = _currentColor == White ? Black : White;
+    if (_grid.winner() != None || _history.isDraw() || !_grid.canMove(next)) {
+        emit gameOver();
+        return;
     }
+
+    _currentColor = next;
+    currentPlayer()->start();
 }
 
 QDebug
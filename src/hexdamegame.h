@@ -21,7 +21,9 @@
 #define HEXDAMEGAME_H
 
 #include "hexdamegrid.h"
+#include "positionhistory.h"
 
+#include <QPair>
 #include <QtDebug> // needed for Q_ASSERT
 
 class AbstractPlayer;
@@ -40,9 +42,11 @@ public:
 
     inline bool debug() const { return _debug; }
 
+    // moves of the current player from c, with the path still ahead of them
+    QList<Move> validMoves(const Coord &c) const;
+
 public slots:
     void makeMove(const Coord &oldCoord, const Coord &newCoord);
-    void makeMove(const Move &move, bool partial = false);
     void makeMove(const MoveBit &move);
     void makePartialMove(const Coord &oldCoord, const Coord &newCoord);
 
@@ -54,10 +58,11 @@ public slots:
     void setDebugMode(bool debug) { _debug = debug; }
     void debugRightClick(Coord c);
     const HexdameGrid &grid() const { return _grid; }
+    const PositionHistory &history() const { return _history; }
 
 signals:
     void boardChanged();
-    //void gameOver();
+    void gameOver();
     void moveFinished();
     void playerMoved();
     void currentHumanPlayer(Color);
@@ -65,7 +70,16 @@ signals:
 private:
     AbstractPlayer *currentPlayer() const { return _currentColor == White ? _white : _black; }
 
+    // valid moves from c that follow the steps made so far, and their remaining path
+    QList<QPair<MoveBit, Move>> movesFrom(const Coord &c) const;
+
     HexdameGrid _grid;
+    PositionHistory _history;
+
+    // a capture the human player makes one step at a time, the grid shows
+    // the steps while _turnStart keeps the position they started from
+    Position _turnStart;
+    Move _partial;
 
     AbstractPlayer *_white = 0;
     AbstractPlayer *_black = 0;
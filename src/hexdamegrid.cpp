@@ -19,528 +19,361 @@
 
 #include "hexdamegrid.h"
 
-#include <limits>
-#include <random>
+#include "movegenerator.h"
 
 #include <QtDebug>
 
-QHash<Coord, quint8> HexdameGrid::_coordToIdx;
-quint64 HexdameGrid::_zobrist_idx[61][4];
-quint64 HexdameGrid::_zobrist_turn;
-
-BitBoard HexdameGrid::_neighbourMasks[61];
-BitBoard HexdameGrid::_northMasks[61];
-BitBoard HexdameGrid::_southMasks[61];
-BitBoard HexdameGrid::_pawnJumpMasks[61][6];
-BitBoard HexdameGrid::_kingJumpMasks[61][6];
+namespace {
+// evaluated by the compiler, like the tables of every grid
+constexpr GridTables tables = GridTables::make();
+static_assert(tables.index(4, 4) == 30, "the centre should be in the middle of the grid");
+static_assert(tables.whitePromotion == BitBoard(0x1f82040400000000ULL)
+              && tables.blackPromotion == BitBoard(0x000000000404083fULL),
+              "pawns should be promoted on the far side");
+}
 
-bool HexdameGrid::initialized = false;
+template<int Radius, class Rules>
+const BasicGridTables<Radius> BasicHexdameGrid<Radius, Rules>::_tables = BasicGridTables<Radius>::make();
 
-HexdameGrid::HexdameGrid()
+template<int Radius, class Rules>
+BasicHexdameGrid<Radius, Rules>::BasicHexdameGrid()
 {
-    if (!initialized) {
-        zobristInit();
-        _coordToIdx.reserve(67);
-    }
-
-    _zobrist_hash = 0;
+    _pos.hash = 0;
     quint8 idx = 0;
     for (quint8 x = 0; x < SIZE; ++x) {
         for (quint8 y = 0; y < SIZE; ++y) {
             static const int s = SIZE / 2;
             if (qAbs(x - y) <= s) {
-                if (!initialized)
-                    _coordToIdx[Coord(x,y)] = idx;
                 if (x < s && y < s) {
-                    _white.set(idx);
-                    _zobrist_hash ^= _zobrist_idx[idx][2];
+                    _pos.white.set(idx);
+                    _pos.hash ^= _tables.zobrist[idx][2];
                 } else if (x > s && y > s) {
-                    _black.set(idx);
-                    _zobrist_hash ^= _zobrist_idx[idx][1];
+                    _pos.black.set(idx);
+                    _pos.hash ^= _tables.zobrist[idx][1];
                 }
                 idx++;
             }
         }
     }
-
-    if (!initialized) {
-        _coordToIdx.squeeze();
-        moveInit();
-        initialized = true;
-    }
 }
 
-HexdameGrid::HexdameGrid(const HexdameGrid &other)
-    : _white(other._white)
-    , _black(other._black)
-    , _kings(other._kings)
-    , _validMoves(other._validMoves)
-    , _maxTaken(other._maxTaken)
-    , _zobrist_hash(other._zobrist_hash)
+template<int Radius, class Rules>
+BasicHexdameGrid<Radius, Rules>::BasicHexdameGrid(const Position &pos)
+    : _pos(pos)
 {
+}
 
+template<int Radius, class Rules>
+bool
+BasicHexdameGrid<Radius, Rules>::operator==(const BasicHexdameGrid &other) const
+{
+    return _pos == other._pos;
 }
 
-HexdameGrid &
-HexdameGrid::operator=(const HexdameGrid &other)
+template<int Radius, class Rules>
+static QList<Coord>
+allCoords()
 {
-    if (this != &other) {
-        _white = other._white;
-        _black = other._black;
-        _kings = other._kings;
-        _validMoves = other._validMoves;
-        _maxTaken = other._maxTaken;
-        _zobrist_hash = other._zobrist_hash;
+    QList<Coord> coords;
+    for (int idx = 0; idx < BasicHexdameGrid<Radius, Rules>::CELLS; ++idx) {
+        coords << BasicHexdameGrid<Radius, Rules>::coord(idx);
     }
-    return *this;
+    return coords;
 }
 
-bool
-HexdameGrid::operator==(const HexdameGrid &other) const
+template<int Radius, class Rules>
+QList<Coord>
+BasicHexdameGrid<Radius, Rules>::coords()
 {
-    return _white == other._white
-        && _black == other._black
-        && _kings == other._kings;
+    static const QList<Coord> coords = allCoords<Radius, Rules>();
+    return coords;
 }
 
+template<int Radius, class Rules>
 Piece
-HexdameGrid::at(quint8 idx) const
+BasicHexdameGrid<Radius, Rules>::at(quint8 idx) const
 {
-    if (_kings.test(idx))
-        return _white.test(idx) ? WhiteKing : BlackKing;
-    if (_white.test(idx)) return WhitePawn;
-    if (_black.test(idx)) return BlackPawn;
+    if (_pos.kings.test(idx))
+        return _pos.white.test(idx) ? WhiteKing : BlackKing;
+    if (_pos.white.test(idx)) return WhitePawn;
+    if (_pos.black.test(idx)) return BlackPawn;
     return Empty;
 }
 
+template<int Radius, class Rules>
 void
-HexdameGrid::set(const Coord& c, Piece p)
+BasicHexdameGrid<Radius, Rules>::set(const Coord& c, Piece p)
 {
-    quint8 idx = _coordToIdx.value(c);
+    quint8 idx = index(c);
+
+    // keep the hash of the position with it
+    if (at(idx) != Empty)
+        _pos.hash ^= zobristString(idx, at(idx));
+    if (p != Empty)
+        _pos.hash ^= zobristString(idx, p);
 
-    _white.reset(idx);
-    _black.reset(idx);
-    _kings.reset(idx);
+    _pos.white.reset(idx);
+    _pos.black.reset(idx);
+    _pos.kings.reset(idx);
 
     switch (p) {
-        case WhitePawn: _white.set(idx); break;
-        case BlackPawn: _black.set(idx); break;
-        case WhiteKing: _white.set(idx); _kings.set(idx); break;
-        case BlackKing: _black.set(idx); _kings.set(idx); break;
+        case WhitePawn: _pos.white.set(idx); break;
+        case BlackPawn: _pos.black.set(idx); break;
+        case WhiteKing: _pos.white.set(idx); _pos.kings.set(idx); break;
+        case BlackKing: _pos.black.set(idx); _pos.kings.set(idx); break;
     }
 }
 
+template<int Radius, class Rules>
 Color
-HexdameGrid::winner() const
+BasicHexdameGrid<Radius, Rules>::winner() const
 {
-    //TODO check for draws
-    if (_black.none())
+    if (_pos.black.none())
         return White;
-    if (_white.none())
+    if (_pos.white.none())
         return Black;
 
     return None;
 }
 
-void
-HexdameGrid::kingPiece()
+template<int Radius, class Rules>
+typename BasicHexdameGrid<Radius, Rules>::BitBoard
+BasicHexdameGrid<Radius, Rules>::kingPiece()
 {
-    static const BitBoard white(0x1f82040400000000ULL);
-    static const BitBoard black(0x000000000404083fULL);
-
-    BitBoard mask = _black & black;
-    if (mask.any()) {
-        _kings |= mask;
-
-//        // use this while I still pass a Coord
-//        _zobrist_hash ^= zobristString(c, BlackPawn);
-//        _zobrist_hash ^= zobristString(c, BlackKing);
-//        return;
-
-        // use this if for some reason I don't pass a Coord anymore
-        quint8 idx = 0;
-        // is this really faster?
-        while (idx < 26 && !mask[idx]) ++idx;
-        _zobrist_hash ^= _zobrist_idx[idx][0]; //blackKing
-        _zobrist_hash ^= _zobrist_idx[idx][1]; //blackPawn
-        return;
+    BitBoard promoted = ((_pos.white & _tables.whitePromotion) | (_pos.black & _tables.blackPromotion)) & ~_pos.kings;
+    foreach (int idx, promoted) {
+        if (_pos.white.test(idx)) {
+            _pos.hash ^= _tables.zobrist[idx][2]; //whitePawn
+            _pos.hash ^= _tables.zobrist[idx][3]; //whiteKing
+        } else {
+            _pos.hash ^= _tables.zobrist[idx][0]; //blackKing
+            _pos.hash ^= _tables.zobrist[idx][1]; //blackPawn
+        }
     }
+    _pos.kings |= promoted;
 
-    mask = _white & white;
-    if (mask.any()) {
-        _kings |= mask;
-
-//        // use this while I still pass a Coord
-//        _zobrist_hash ^= zobristString(c, WhitePawn);
-//        _zobrist_hash ^= zobristString(c, WhiteKing);
-//        return;
-
-        // use this if for some reason I don't pass a Coord anymore
-        quint8 idx = 34;
-        // is this really faster?
-        while (idx < 61 && !mask[idx]) ++idx;
-        _zobrist_hash ^= _zobrist_idx[idx][2]; //whitePawn
-        _zobrist_hash ^= _zobrist_idx[idx][3]; //whiteKing
-        return;
-    }
+    return promoted;
 }
 
+template<int Radius, class Rules>
 void
-HexdameGrid::makeMove(const Move &move, bool partial)
+BasicHexdameGrid<Radius, Rules>::makeMove(const Move &move, bool partial)
 {
     if (move.from() != move.to()) {
-        _zobrist_hash ^= zobristString(move.to(), at(move.from()));
-        _zobrist_hash ^= zobristString(move.from(), at(move.from()));
+        _pos.hash ^= zobristString(move.to(), at(move.from()));
+        _pos.hash ^= zobristString(move.from(), at(move.from()));
 
         set(move.to(), at(move.from()));
         set(move.from(), Empty);
     }
 
     foreach (Coord c, move.taken) {
-        _zobrist_hash ^= zobristString(c, at(c));
+        _pos.hash ^= zobristString(c, at(c));
         set(c, Empty);
     }
 
-    if (partial) {
-        _validMoves.clear();
-        _maxTaken = 0;
-        dfs(move.to());
-    } else {
+    if (!partial) {
         kingPiece();
-        _zobrist_hash ^= _zobrist_turn;
+        _pos.hash ^= _tables.zobristTurn;
     }
 }
 
+template<int Radius, class Rules>
 void
-HexdameGrid::makeMoveBit(const MoveBit &move)
+BasicHexdameGrid<Radius, Rules>::makeMoveBit(const MoveBit &move)
 {
-    Q_ASSERT(move.path.count() == 2 || move.path.count() == 0);
-    Piece p;
-    quint8 from, to;
-    for (int i = 0; i < 61; ++i) {
-        if (move.path[i]) {
-             if (at(i) != Empty) {
-                 from = i;
-                 p = at(i);
-             } else {
-                 to = i;
-             }
-        }
-        if (move.taken[i]) _zobrist_hash ^= zobristString(i, at(i));
+    Undo undo;
+    doMove(move, undo);
+}
+
+template<int Radius, class Rules>
+void
+BasicHexdameGrid<Radius, Rules>::doMove(const MoveBit &move, Undo &undo)
+{
+    const BitBoard path = move.path();
+    const BitBoard taken = move.taken();
+    undo.path = path;
+    undo.taken = taken;
+    undo.takenKings = taken & _pos.kings;
+    undo.hash = _pos.hash;
+
+    foreach (int idx, taken) {
+        _pos.hash ^= zobristString(idx, at(idx));
     }
-    if (move.path.any()) {
-        _zobrist_hash ^= zobristString(from, p);
-        _zobrist_hash ^= zobristString(to, p);
+    if (!move.empty()) {
+        Piece p = at(move.from());
+        _pos.hash ^= zobristString(move.from(), p);
+        _pos.hash ^= zobristString(move.to(), p);
     }
 
-    if ((_white & move.path).any()) {
-        _white ^= move.path;
-        _black &= ~move.taken;
+    if ((_pos.white & path).any()) {
+        _pos.white ^= path;
+        _pos.black &= ~taken;
     } else {
-        _black ^= move.path;
-        _white &= ~move.taken;
+        _pos.black ^= path;
+        _pos.white &= ~taken;
     }
-    if ((_kings & move.path).any()) {
-        _kings ^= move.path;
+    if ((_pos.kings & path).any()) {
+        _pos.kings ^= path;
     }
-    _kings &= ~move.taken;
+    _pos.kings &= ~taken;
 
-    kingPiece();
-    _zobrist_hash ^= _zobrist_turn;
+    undo.promoted = kingPiece();
+    _pos.hash ^= _tables.zobristTurn;
 }
 
+template<int Radius, class Rules>
 void
-HexdameGrid::move(const Coord &from, const Coord &to)
+BasicHexdameGrid<Radius, Rules>::undoMove(const Undo &undo)
+{
+    _pos.kings &= ~undo.promoted;
+    if ((_pos.white & undo.path).any()) {
+        _pos.white ^= undo.path;
+        _pos.black |= undo.taken;
+    } else {
+        _pos.black ^= undo.path;
+        _pos.white |= undo.taken;
+    }
+    if ((_pos.kings & undo.path).any()) {
+        _pos.kings ^= undo.path;
+    }
+    _pos.kings |= undo.takenKings;
+
+    _pos.hash = undo.hash;
+}
+
+template<int Radius, class Rules>
+void
+BasicHexdameGrid<Radius, Rules>::move(const Coord &from, const Coord &to)
 {
     if (!isEmpty(to)) return;
 
     if (to == from) return;
 
-    _zobrist_hash ^= zobristString(to, at(from));
-    _zobrist_hash ^= zobristString(from, at(from));
+    _pos.hash ^= zobristString(to, at(from));
+    _pos.hash ^= zobristString(from, at(from));
 
     set(to, at(from));
     set(from, Empty);
 }
 
-QHash<Coord, QMultiHash<Coord, Move>>
-HexdameGrid::computeValidMoves(Color col) const
+template<int Radius, class Rules>
+QList<typename BasicHexdameGrid<Radius, Rules>::MoveBit>
+BasicHexdameGrid<Radius, Rules>::computeValidMoveBits(Color col) const
 {
-    _maxTaken = 0;
-    _validMoves.clear();
-
-    foreach (Coord from, coords()) {
-        if (color(from) != col) continue;
-
-        dfs(from);
-    }
-
-    if (!_validMoves.empty()) return _validMoves;
-
-    if (col == White)
-        _validMoves.reserve(2*_white.count());
-    else if (col == Black)
-        _validMoves.reserve(2*_black.count());
-
-    // don't change the order  |<----------Whites moves---------->|<-------------Blacks moves------------->|
-    const static QList<Coord> l{Coord(1,0), Coord(0,1), Coord(1,1), Coord(0,-1), Coord(-1,0), Coord(-1,-1)};
-    foreach(Coord from, coords()) {
-        if (color(from) != col) continue;
-        for (int i = 0; i < l.size(); ++i) {
-            if (i <  3 && isPawn(from) && isBlack(from)) i = 3; // jump to Blacks moves
-            if (i >= 3 && isPawn(from) && isWhite(from)) break; // ignore the rest
+    MoveList moves;
+    computeValidMoveBits(col, moves);
 
-            for (int j = 1; j < 9; ++j) {
-                Coord to = from + j*l.at(i);
-
-                if (!contains(to)) break;
-                if (!isEmpty(to)) break;
-
-                // create Move and add to list
-                Move m;
-                m.path << from << to;
-                _validMoves[from].insert(to, m);
-
-                if (isPawn(from)) break; // Pawns can't jump further than 1
-            }
-        }
+    QList<MoveBit> list;
+    list.reserve(moves.size());
+    for (int i = 0; i < moves.size(); ++i) {
+        list << moves.at(i);
     }
-
-    return _validMoves;
+    return list;
 }
 
-QList<MoveBit>
-HexdameGrid::computeValidMoveBits(Color col) const
+template<int Radius, class Rules>
+void
+BasicHexdameGrid<Radius, Rules>::computeValidMoveBits(Color col, MoveList &moves) const
 {
-    _maxTaken = 0;
-    _validMoveBits.clear();
-
-    for (int i = 0; i < 61; ++i) {
-        if (color(i) != col) continue;
-        dfs(i);
-    }
-
-    if (!_validMoveBits.empty()) return _validMoveBits;
-
-    if (col == White)
-        _validMoveBits.reserve(2*_white.count());
-    else if (col == Black)
-        _validMoveBits.reserve(2*_black.count());
-
-    for (int from = 0; from < 61; ++from) {
-        if (color(from) != col) continue;
+    MoveGenerator(*this).validMoveBits(col, moves);
+}
 
-        BitBoard dests;
-        if (col == White) {
-            dests = ~(_white | _black) & _northMasks[from];
-        } else {
-            dests = ~(_white | _black) & _southMasks[from];
-        }
+template<int Radius, class Rules>
+typename BasicHexdameGrid<Radius, Rules>::BitBoard
+BasicHexdameGrid<Radius, Rules>::capturingPieces(Color col) const
+{
+    return MoveGenerator(*this).capturingPieces(col);
+}
 
-        for (int to = 0; to < 61; ++to) {
-            if (!dests[to]) continue;
-            MoveBit m;
-            m.path.set(from);
-            m.path.set(to);
-            _validMoveBits << m;
-        }
-    }
+template<int Radius, class Rules>
+bool
+BasicHexdameGrid<Radius, Rules>::canMove(Color col) const
+{
+    return MoveGenerator(*this).hasMoves(col);
+}
 
-    return _validMoveBits;
+template<int Radius, class Rules>
+QList<Move>
+BasicHexdameGrid<Radius, Rules>::movePaths(const MoveBit &move) const
+{
+    return MoveGenerator(*this).paths(move);
 }
 
-void
-HexdameGrid::dfs(const Coord& from, Move move) const
+template<int Radius, class Rules>
+quint64
+BasicHexdameGrid<Radius, Rules>::computeHash(Color turn) const
 {
-    static Color col;
-    static bool king;
-    if (move.empty()) {
-        move.path << from;
-        col = color(from);
-        king = isKing(from);
+    quint64 hash = turn == Black ? _tables.zobristTurn : 0;
+    foreach (int idx, _pos.white | _pos.black) {
+        hash ^= zobristString(idx, at(idx));
     }
+    return hash;
+}
 
-    const static QList<Coord> l{Coord(1,0), Coord(-1,0), Coord(0,1), Coord(0,-1), Coord(1,1), Coord(-1,-1)};
-    foreach (Coord lv, l) {
-        for (int i = 1; i < 9; ++i) {
-            Coord over = from + i*lv;
-
-            if (!contains(over)) break;           // not on the grid
-            if (col == color(over)) break;        // same colour
-            if (move.taken.contains(over)) break; // already took piece
-
-            if (col == -color(over)) {
-                while (++i < 9) {
-                    Coord to = from + i*lv;
-                    // non-empty cell after jumping
-                    if (!contains(to) || (move.from() != to && !isEmpty(to))) { i = 9; break; }
-
-                    // create a new Move
-                    Move newMove(move);
-                    newMove.taken << over;
-                    newMove.path << to;
-
-                    // update/reset validMoves list
-                    if (newMove.taken.size() >= _maxTaken) {
-                        if (newMove.taken.size() > _maxTaken) {
-                            _validMoves.clear();
-                            _maxTaken = newMove.taken.size();
-                        }
-                        bool dup = false;
-                        foreach (Move oldMove, _validMoves.value(move.from())) {
-                            if (dup = oldMove == newMove) break; // moves are equivalent
-                        }
-                        if (!dup) _validMoves[newMove.from()].insert(to, newMove);
-                    }
-
-                    // recursive call
-                    dfs(to, newMove);
-
-                    if (!king) break; // Pawns can't jump further than 1
-                }
-            }
-            if (!king) break; // Pawns can't jump further than 1
+template<int Radius, class Rules>
+QString
+BasicHexdameGrid<Radius, Rules>::toString(Color turn) const
+{
+    QString str;
+    for (int idx = 0; idx < CELLS; ++idx) {
+        switch (at(idx)) {
+            case BlackKing: str += 'B'; break;
+            case BlackPawn: str += 'b'; break;
+            case Empty:     str += '.'; break;
+            case WhitePawn: str += 'w'; break;
+            case WhiteKing: str += 'W'; break;
         }
     }
+    str += turn == Black ? " b" : " w";
+    return str;
 }
 
-void
-HexdameGrid::dfs(const quint8 &from, MoveBit move) const
+template<int Radius, class Rules>
+bool
+BasicHexdameGrid<Radius, Rules>::fromString(const QString &str, BasicHexdameGrid &grid, Color &turn)
 {
-    static Color col;
-    static bool king;
-    if (move.empty()) {
-        move.path.set(from);
-        col = color(from);
-        king = isKing(from);
-    }
-
-    const BitBoard &cur = col == White ? _white : _black;
-    const BitBoard &opp = col == White ? _black : _white;
-
-
-    if (!king) {
-        // may not jump
-        if ((opp & _neighbourMasks[from]).none()) return;
-
-        for (int d = 0; d < 6; ++d) {
-            if ((opp & _pawnJumpMasks[from][d]).none()) continue; // can't jump in direction d
-            if ((move.taken & _pawnJumpMasks[from][d]).any()) continue; // already took piece
-            size_t to = 0;
-            {
-                BitBoard tmp = _pawnJumpMasks[from][d] & ~_neighbourMasks[from];
-                while (!(tmp).test(to)) ++to;
-            }
-            if ((cur | opp).test(to)) continue; // dest is not free
-
-            MoveBit newMove(move);
-            // reset from only if we're in a multi-jump
-            if (newMove.path.count() == 2)
-                newMove.path.reset(from);
-            newMove.path.set(to);
-            newMove.taken |= _pawnJumpMasks[from][d] & _neighbourMasks[from];
-            Q_ASSERT(newMove.path.count() == 2 || newMove.path.count() == 0);
-
-            size_t s = newMove.taken.count();
-            if (s >= _maxTaken) {
-                if (s > _maxTaken) {
-                    _validMoveBits.clear();
-                    _maxTaken = s;
-                }
-                if(!_validMoveBits.contains(newMove))
-                    _validMoveBits << newMove;
-            }
-
-            dfs(to, newMove);
+    const QByteArray s = str.trimmed().toLatin1();
+    if (s.size() != CELLS + 2 || s[CELLS] != ' ')
+        return false;
+
+    Position pos = Position();
+    for (int idx = 0; idx < CELLS; ++idx) {
+        switch (s[idx]) {
+            case 'B': pos.kings.set(idx); // fall through
+            case 'b': pos.black.set(idx); break;
+            case 'W': pos.kings.set(idx); // fall through
+            case 'w': pos.white.set(idx); break;
+            case '.': break;
+            default: return false;
         }
-    } else {
-        for (int d = 0; d < 6; ++d) {
-            if ((opp & _kingJumpMasks[from][d]).none()) continue; // can't jump in direction d
-
-            BitBoard dests;
-            quint8 takenIdx = -1;
-
-            quint8 t_min, t_max, t_inc;
-            if (d < 3) { // going North
-                t_min = 0;
-                t_max = 61;
-                t_inc = 1;
-            } else { // going South
-                t_min = 60;
-                t_max = -1;
-                t_inc = -1;
-            }
-
-            bool canJump = false;
-            quint8 t = t_min;
-            // I don't like this loop
-            while (t != t_max) {
-                if ((cur & _kingJumpMasks[from][d]).test(t)) break;
-
-                if (canJump && _kingJumpMasks[from][d].test(t)) {
-                    if (isEmpty(t))
-                        dests.set(t);
-                    else
-                        break;
-                }
-
-                if ((opp & _kingJumpMasks[from][d]).test(t)) {
-                    canJump = true;
-                    takenIdx = t;
-                }
-
-                t+=t_inc;
-            }
-
-            if (takenIdx > 60) continue; // we're trying to jump out of the board
-
-            if (move.taken.test(takenIdx)) continue; // already took piece
-            size_t to = 0;
-            for (int to = 0; to < 61; ++to) {
-                if (!dests.test(to)) continue;
-
-                MoveBit newMove(move);
-                // reset from only if we're in a multi-jump
-                if (newMove.path.count() == 2)
-                    newMove.path.reset(from);
-                newMove.path.set(to);
-                newMove.taken.set(takenIdx);
-                Q_ASSERT(newMove.path.count() == 2);
-
-                size_t s = newMove.taken.count();
-                if (s >= _maxTaken) {
-                    if (s > _maxTaken) {
-                        _validMoveBits.clear();
-                        _maxTaken = s;
-                    }
-                    if(!_validMoveBits.contains(newMove))
-                        _validMoveBits << newMove;
-                }
+    }
 
-                dfs(to, newMove);
-            }
-        }
+    switch (s[CELLS + 1]) {
+        case 'w': turn = White; break;
+        case 'b': turn = Black; break;
+        default: return false;
     }
+
+    grid = BasicHexdameGrid(pos);
+    grid._pos.hash = grid.computeHash(turn);
+    return true;
 }
 
-void
-HexdameGrid::zobristInit()
+template<int Radius, class Rules>
+typename BasicHexdameGrid<Radius, Rules>::BitBoard
+BasicHexdameGrid<Radius, Rules>::shift(const BitBoard &b, int d)
 {
-    std::random_device rd;
-    std::mt19937_64 gen(rd());
-    std::uniform_int_distribution<quint64> dis(std::numeric_limits<quint64>::min(), std::numeric_limits<quint64>::max());
-
-    for (int i = 0; i < 61; ++i) {
-        for (int j = 0; j < 4; ++j) {
-            _zobrist_idx[i][j] = dis(gen);
-        }
+    BitBoard shifted;
+    for (int i = 0; i < _tables.shiftCount[d]; ++i) {
+        shifted |= (b & _tables.shifts[d][i].from).shifted(_tables.shifts[d][i].amount);
     }
-
-    _zobrist_turn = dis(gen);
+    return shifted;
 }
 
+template<int Radius, class Rules>
 quint64
-HexdameGrid::zobristString(quint8 idx, const Piece& p)
+BasicHexdameGrid<Radius, Rules>::zobristString(quint8 idx, const Piece& p)
 {
     Q_ASSERT(p != Empty);
     int j;
@@ -552,13 +385,14 @@ HexdameGrid::zobristString(quint8 idx, const Piece& p)
         case WhiteKing: j = 3; break;
     }
 
-    return _zobrist_idx[idx][j];
+    return _tables.zobrist[idx][j];
 }
 
+template<int Radius, class Rules>
 quint64
-HexdameGrid::zobristString(const Coord& c, const Piece& p)
+BasicHexdameGrid<Radius, Rules>::zobristString(const Coord& c, const Piece& p)
 {
-    int i = _coordToIdx.value(c);
+    int i = index(c);
     int j;
 
     switch (p) {
@@ -568,58 +402,12 @@ HexdameGrid::zobristString(const Coord& c, const Piece& p)
         case WhiteKing: j = 3; break;
     }
 
-    return _zobrist_idx[i][j];
+    return _tables.zobrist[i][j];
 }
 
-void print(BitBoard grid) {
-    qDebug() << QString::number(grid.to_ullong(), 2).rightJustified(64, '0');
-    QString str;
-    for (int i = 63; i >= 0; --i) {
-        if (i % 10 == 0)
-            str += QString::number(i/10);
-        else
-            str += QString::number(i%10);
-    }
-    qDebug() << str;
-}
-
-void
-HexdameGrid::moveInit()
-{
-    // don't change order:     |<-NorthWest->|<---North--->|<-NorthEast->|<-SouthEast->|<---South--->|<-SouthWest->|
-    const static QList<Coord> l{Coord( 1, 0), Coord( 1, 1), Coord( 0, 1), Coord( 0,-1), Coord(-1,-1), Coord(-1, 0)};
-    foreach (Coord d, _coordToIdx.keys()) {
-        quint8 idx = _coordToIdx.value(d);
-        qDebug() << "idx: " << idx;
-        for (int c = 0; c < l.size(); ++c) {
-            Coord one = d + 1*l.at(c);
-            if (!contains(one)) continue; // not on the grid
-
-            if (c < 3) { // going north
-                _northMasks[idx].set(_coordToIdx.value(one));
-            } else { // going south
-                _southMasks[idx].set(_coordToIdx.value(one));
-            }
-
-            Coord two = d + 2*l.at(c);
-            if (!contains(two)) continue; // not on the grid
-
-            _pawnJumpMasks[idx][c].set(_coordToIdx.value(one));
-            _pawnJumpMasks[idx][c].set(_coordToIdx.value(two));
-
-            _neighbourMasks[idx].set(_coordToIdx.value(one));
-            qDebug() << "c: " << c;
-            print(_pawnJumpMasks[idx][c]);
-
-            _kingJumpMasks[idx][c].set(_coordToIdx.value(one));
-            _kingJumpMasks[idx][c].set(_coordToIdx.value(two));
-            for (int i = 3; i < 9; ++i) {
-                Coord next = d + i*l.at(c);
-                if (!contains(next)) break; // not on the grid
-
-                _kingJumpMasks[idx][c].set(_coordToIdx.value(next));
-            }
-        }
-        print(_neighbourMasks[idx]);
-    }
-}
+template class BasicHexdameGrid<4>;
+template class BasicHexdameGrid<5>;
+template class BasicHexdameGrid<6>;
+template class BasicHexdameGrid<4, FreeCaptureRules>;
+template class BasicHexdameGrid<4, ShortKingRules>;
+template class BasicHexdameGrid<4, ForwardCaptureRules>;
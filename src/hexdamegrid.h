@@ -21,59 +21,120 @@
 #define HEXDAMEGRID_H
 
 #include "commondefs.h"
+#include "gridtables.h"
+#include "movelist.h"
+#include "position.h"
+#include "rules.h"
 
 #include <QVector>
 
 using namespace Hexdame;
 
-class HexdameGrid
+template<int Radius, class Rules = StandardRules> class BasicMoveGenerator;
+
+/**
+ * A hexagonal grid with Radius cells from the centre to each side, whose
+ * moves follow Rules.
+ *
+ * The game is played on the standard HexdameGrid, the larger ones and the
+ * other rules share the same code to see how they play out. Instantiated in
+ * hexdamegrid.cpp for radius 4, 5 and 6 (61, 91 and 127 cells) with the
+ * standard rules and for radius 4 with each variant of rules.h.
+ */
+template<int Radius, class Rules = StandardRules>
+class BasicHexdameGrid
 {
 public:
-    HexdameGrid();
-    HexdameGrid(const HexdameGrid &other);
-    HexdameGrid &operator=(const HexdameGrid &other);
-    bool operator==(const HexdameGrid &other) const;
+    typedef BasicGridTables<Radius> Tables;
+    typedef typename Tables::BitBoard BitBoard;
+    typedef BasicPosition<BitBoard> Position;
+    typedef BasicMoveBit<BitBoard> MoveBit;
+    typedef BasicMoveList<MoveBit, (Tables::CELLS <= 64 ? 256 : 512)> MoveList;
+    typedef BasicMoveGenerator<Radius, Rules> MoveGenerator;
+
+    static const int CELLS = Tables::CELLS;
+
+    BasicHexdameGrid();
+    explicit BasicHexdameGrid(const Position &pos);
+    bool operator==(const BasicHexdameGrid &other) const;
 
     Piece at(quint8 idx) const;
 
-    Piece at(const Coord &c) const { return at(_coordToIdx.value(c)); }
+    Piece at(const Coord &c) const { return at(index(c)); }
+    // also updates the hash, the side to move stays what it was
     void set(const Coord &c, Piece p);
 
-    static QList<Coord> coords() { return _coordToIdx.keys(); }
-    static bool contains(const Coord &c) { return _coordToIdx.contains(c); }
+    static QList<Coord> coords();
+    static bool contains(const Coord &c) { return index(c) >= 0; }
+    // cell index of c, -1 if it isn't on the grid
+    static int index(const Coord &c) { return _tables.index(c.x, c.y); }
+    static Coord coord(int idx) { return Coord(_tables.idxToCoord[idx][0], _tables.idxToCoord[idx][1]); }
 
     // convenience functions
-    inline bool isWhite(quint8 idx) const { return _white.test(idx); }
-    inline bool isBlack(quint8 idx) const { return _black.test(idx); }
-    inline bool isEmpty(quint8 idx) const { return !(_white | _black).test(idx); }
-    inline bool  isPawn(quint8 idx) const { return ((_white | _black) & ~_kings).test(idx); }
-    inline bool  isKing(quint8 idx) const { return _kings.test(idx); }
+    inline bool isWhite(quint8 idx) const { return _pos.white.test(idx); }
+    inline bool isBlack(quint8 idx) const { return _pos.black.test(idx); }
+    inline bool isEmpty(quint8 idx) const { return !(_pos.white | _pos.black).test(idx); }
+    inline bool  isPawn(quint8 idx) const { return ((_pos.white | _pos.black) & ~_pos.kings).test(idx); }
+    inline bool  isKing(quint8 idx) const { return _pos.kings.test(idx); }
     inline Color  color(quint8 idx) const
         { if (isWhite(idx)) return White;
           if (isBlack(idx)) return Black;
           return None; }
 
-    inline bool isWhite(const Coord &c) const { return isWhite(_coordToIdx[c]); }
-    inline bool isBlack(const Coord &c) const { return isBlack(_coordToIdx[c]); }
-    inline bool isEmpty(const Coord &c) const { return isEmpty(_coordToIdx[c]); }
-    inline bool  isPawn(const Coord &c) const { return  isPawn(_coordToIdx[c]); }
-    inline bool  isKing(const Coord &c) const { return  isKing(_coordToIdx[c]); }
-    inline Color  color(const Coord &c) const { return   color(_coordToIdx[c]); }
+    inline bool isWhite(const Coord &c) const { return isWhite(index(c)); }
+    inline bool isBlack(const Coord &c) const { return isBlack(index(c)); }
+    inline bool isEmpty(const Coord &c) const { return isEmpty(index(c)); }
+    inline bool  isPawn(const Coord &c) const { return  isPawn(index(c)); }
+    inline bool  isKing(const Coord &c) const { return  isKing(index(c)); }
+    inline Color  color(const Coord &c) const { return   color(index(c)); }
 
+    // only used to show the steps of a capture, the search uses doMove
     void makeMove(const Move &move, bool partial = false);
     void makeMoveBit(const MoveBit &move);
+
+    // everything needed to take back a move made with doMove
+    struct Undo {
+        BitBoard path;
+        BitBoard taken;
+        BitBoard takenKings;
+        BitBoard promoted;
+        quint64 hash;
+    };
+    void doMove(const MoveBit &move, Undo &undo);
+    void undoMove(const Undo &undo);
     // does not check validity and calculates all valid moves, use for debug
     void move(const Coord &from, const Coord &to);
 
+    // the side that took all pieces of the other, draws and a side left
+    // without moves depend on whose turn it is and on the game's history
     Color winner() const;
-    QHash<Coord, QMultiHash<Coord, Move>> computeValidMoves(Color col) const;
+    // whether col has any move, a side that can't move has lost
+    bool canMove(Color col) const;
     QList<MoveBit> computeValidMoveBits(Color col) const;
-
-    quint64 zobristHash() const { return _zobrist_hash; }
-
-    static QHash<Coord, quint8> _coordToIdx;
+    void computeValidMoveBits(Color col, MoveList &moves) const;
+    // pieces of colour col that have at least one capture available
+    BitBoard capturingPieces(Color col) const;
+    // the jumps making up move, as shown to the user
+    QList<Move> movePaths(const MoveBit &move) const;
+
+    quint64 zobristHash() const { return _pos.hash; }
+    const Position &position() const { return _pos; }
+    // the hash of the pieces computed from scratch, White moves first so
+    // the turn key is in whenever Black is to move
+    quint64 computeHash(Color turn) const;
+
+    /**
+     * A position on a single line: the cells in index order, 'w' and 'b'
+     * for pawns, 'W' and 'B' for kings and '.' for empty cells, followed by
+     * a space and the side to move, 'w' or 'b'.
+     */
+    QString toString(Color turn) const;
+    // reads what toString wrote, false if str isn't a position
+    static bool fromString(const QString &str, BasicHexdameGrid &grid, Color &turn);
 
 private:
+    friend class BasicMoveGenerator<Radius, Rules>;
+
     enum Direction {
         NorthWest = 0,
         North,
@@ -83,34 +144,37 @@ private:
         SouthWest
     };
 
-    void dfs(const Coord &from, Move move = Move()) const;
-    void dfs(const quint8 &from, MoveBit move = MoveBit()) const;
-    void kingPiece();
+    // promotes pawns that reached the far side, returns the promoted pieces
+    BitBoard kingPiece();
 
-    static bool initialized;
-    static const int SIZE = 9;
-    static void zobristInit();
+    static const int SIZE = Tables::SIZE;
     static quint64 zobristString(quint8 idx, const Piece &p);
     static quint64 zobristString(const Coord &c, const Piece &p);
-    static quint64 _zobrist_idx[61][4];
-    static quint64 _zobrist_turn;
-    quint64 _zobrist_hash;
 
+    Position _pos;
 
-    BitBoard _white = 0;
-    BitBoard _black = 0;
-    BitBoard _kings = 0;
+    static const Tables _tables;
 
-    mutable QHash<Coord, QMultiHash<Coord, Move>> _validMoves;
-    mutable QList<MoveBit> _validMoveBits;
-    mutable quint8 _maxTaken;
+    // moves every set bit one cell in direction d, dropping those leaving the grid
+    static BitBoard shift(const BitBoard &b, int d);
+    static int opposite(int d) { return SouthWest - d; }
 
-    static void moveInit();
-    static BitBoard _neighbourMasks[61];
-    static BitBoard _northMasks[61];
-    static BitBoard _southMasks[61];
-    static BitBoard _pawnJumpMasks[61][6];
-    static BitBoard _kingJumpMasks[61][6];
+    // North rays run towards higher indices, South rays towards lower ones
+    static int firstAlongRay(const BitBoard &b, int d) { return d <= NorthEast ? b.first() : b.last(); }
 };
 
+extern template class BasicHexdameGrid<4>;
+extern template class BasicHexdameGrid<5>;
+extern template class BasicHexdameGrid<6>;
+extern template class BasicHexdameGrid<4, FreeCaptureRules>;
+extern template class BasicHexdameGrid<4, ShortKingRules>;
+extern template class BasicHexdameGrid<4, ForwardCaptureRules>;
+
+// the grid the game is played on
+typedef BasicHexdameGrid<4> HexdameGrid;
+static_assert(std::is_same<HexdameGrid::MoveBit, MoveBit>::value
+              && std::is_same<HexdameGrid::MoveList, MoveList>::value
+              && std::is_same<HexdameGrid::Position, Position>::value,
+              "the standard grid should use the standard types");
+
 #endif // HEXDAMEGRID_H
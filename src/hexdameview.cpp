@@ -90,7 +90,7 @@ HexdameView::HexdameView(HexdameGame *game, QWidget *parent)
         coordToPiece[c] = p;
 
 #if 1   // add text coords
-        QGraphicsTextItem *t = new QGraphicsTextItem(QString("{%1,%2}\n%3").arg(c.x).arg(c.y).arg(game->grid()._coordToIdx.value(c)), h);
+        QGraphicsTextItem *t = new QGraphicsTextItem(QString("{%1,%2}\n%3").arg(c.x).arg(c.y).arg(HexdameGrid::index(c)), h);
         t->setZValue(1);
         t->rotate(180);
 #endif
@@ -143,7 +143,10 @@ HexdameView::mousePressEvent(QMouseEvent *event)
         if (color(piece->state()) != _game->currentColor()) return;
     }
 
-    QMultiHash<Coord, Move> moves = _game->grid().computeValidMoves(_game->currentColor()).value(piece->coord());
+    QMultiHash<Coord, Move> moves;
+    foreach (const Move &move, _game->validMoves(piece->coord())) {
+        moves.insert(move.to(), move);
+    }
 
     if (!_game->debug() && moves.empty()) return;
 
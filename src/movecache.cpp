@@ -0,0 +1,89 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "movecache.h"
+
+MoveCache::MoveCache(int megabytes)
+    : _mask(0)
+    , _ringMask(0)
+    , _written(0)
+{
+    if (megabytes > 0) {
+        // largest power of two of entries that fits with their moves
+        const quint64 entrySize = sizeof(Entry) + RING_MOVES_PER_ENTRY * sizeof(MoveBit);
+        quint64 entries = 1;
+        while (entries * 2 * entrySize <= quint64(megabytes) << 20) {
+            entries *= 2;
+        }
+        _table.resize(int(entries));
+        _mask = entries - 1;
+        // a power of two as well, at least a list of every length fits
+        quint64 moves = entries * RING_MOVES_PER_ENTRY;
+        while (moves < quint64(MAX_MOVES)) {
+            moves *= 2;
+        }
+        _ring.resize(int(moves));
+        _ringMask = moves - 1;
+    }
+    clear();
+}
+
+void
+MoveCache::validMoves(const HexdameGrid &grid, Color col, MoveList &moves)
+{
+    if (_table.isEmpty()) {
+        grid.computeValidMoveBits(col, moves);
+        return;
+    }
+
+    Entry &entry = _table[grid.zobristHash() & _mask];
+    _stats.probes++;
+    // the moves are still there unless the ring went round over them
+    if (entry.color == col && entry.position == grid.position()
+            && _written - entry.start <= _ringMask + 1) {
+        _stats.hits++;
+        moves.clear();
+        for (int i = 0; i < entry.size; ++i) {
+            moves << _ring.at(int((entry.start + i) & _ringMask));
+        }
+        return;
+    }
+
+    grid.computeValidMoveBits(col, moves);
+    if (moves.size() > MAX_MOVES) {
+        _stats.tooLong++;
+        return;
+    }
+    entry.position = grid.position();
+    entry.color = col;
+    entry.size = moves.size();
+    entry.start = _written;
+    for (int i = 0; i < moves.size(); ++i) {
+        _ring[int((_written + i) & _ringMask)] = moves[i];
+    }
+    _written += moves.size();
+}
+
+void
+MoveCache::clear()
+{
+    for (int i = 0; i < _table.size(); ++i) {
+        _table[i].color = None;
+    }
+    _stats = Stats();
+}
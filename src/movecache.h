@@ -0,0 +1,81 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef MOVECACHE_H
+#define MOVECACHE_H
+
+#include "hexdamegrid.h"
+
+#include <QVector>
+
+/**
+ * Valid moves of recently seen positions, found by their Zobrist hash.
+ *
+ * Each pass of MTD(f) and each iteration of the deepening visits mostly the
+ * same nodes as the one before, this saves generating their moves again,
+ * which is costly for long king captures. It is a fixed size table where a
+ * new entry simply replaces the old one in its slot. An entry keeps the whole
+ * position, a hit is never the list of another one. The moves themselves go
+ * round a ring shared by all entries, so long lists take no room from short
+ * ones, and an entry whose moves have been written over is a miss. Lists
+ * longer than a MoveList holds without allocating are not kept. Not thread
+ * safe, use one per search thread.
+ */
+class MoveCache
+{
+public:
+    struct Stats {
+        quint64 probes;
+        quint64 hits;
+        quint64 tooLong;  // lists too long to be kept
+
+        double hitRate() const { return probes ? double(hits) / probes : 0; }
+    };
+
+    // size in megabytes, 0 disables the cache
+    explicit MoveCache(int megabytes);
+
+    bool enabled() const { return !_table.isEmpty(); }
+
+    // the valid moves of col, generated only if they aren't cached
+    void validMoves(const HexdameGrid &grid, Color col, MoveList &moves);
+
+    const Stats &stats() const { return _stats; }
+    void clear();
+
+private:
+    static const int MAX_MOVES = MoveList::CAPACITY;
+    // room for this many moves per entry, most positions have far fewer
+    static const int RING_MOVES_PER_ENTRY = 16;
+
+    struct Entry {
+        Position position;
+        qint8 color;  // None for an empty entry
+        quint16 size;
+        quint64 start;  // moves written to the ring before these
+    };
+
+    QVector<Entry> _table;
+    quint64 _mask;
+    QVector<MoveBit> _ring;
+    quint64 _ringMask;
+    quint64 _written;  // moves written to the ring so far
+    Stats _stats;
+};
+
+#endif // MOVECACHE_H
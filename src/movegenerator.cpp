@@ -0,0 +1,720 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "movegenerator.h"
+
+#include <cstring>
+
+#include <QtDebug>
+
+template<int Radius, class Rules>
+BasicMoveGenerator<Radius, Rules>::BasicMoveGenerator(const Grid &grid)
+    : _grid(grid)
+    , _pos(grid.position())
+{
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::validMoveBits(Color col, MoveList &moves) const
+{
+    if (col == White) validMoveBits<White>(moves);
+    else validMoveBits<Black>(moves);
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::validCaptures(Color col, MoveList &moves) const
+{
+    if (col == White) validCaptures<White>(moves);
+    else validCaptures<Black>(moves);
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::validQuietMoves(Color col, MoveList &moves) const
+{
+    if (col == White) validQuietMoves<White>(moves);
+    else validQuietMoves<Black>(moves);
+}
+
+template<int Radius, class Rules>
+typename BasicMoveGenerator<Radius, Rules>::BitBoard
+BasicMoveGenerator<Radius, Rules>::capturingPieces(Color col) const
+{
+    return col == White ? capturingPieces<White>() : capturingPieces<Black>();
+}
+
+template<int Radius, class Rules>
+bool
+BasicMoveGenerator<Radius, Rules>::hasMoves(Color col) const
+{
+    return col == White ? hasMoves<White>() : hasMoves<Black>();
+}
+
+template<int Radius, class Rules>
+bool
+BasicMoveGenerator<Radius, Rules>::isPlausible(Color col, const MoveBit &move) const
+{
+    return col == White ? isPlausible<White>(move) : isPlausible<Black>(move);
+}
+
+template<int Radius, class Rules>
+template<Color Us>
+void
+BasicMoveGenerator<Radius, Rules>::validMoveBits(MoveList &moves) const
+{
+    validCaptures<Us>(moves);
+    if (moves.empty())
+        validQuietMoves<Us>(moves);
+}
+
+template<int Radius, class Rules>
+template<Color Us>
+void
+BasicMoveGenerator<Radius, Rules>::validCaptures(MoveList &moves) const
+{
+    moves.clear();
+
+    // only start a capture search from pieces that can take something
+    const BitBoard capturers = capturingPieces<Us>();
+    if (capturers.any()) {
+        const BitBoard &opp = Us == White ? _pos.black : _pos.white;
+        CaptureSearch search;
+        int maxTaken = 0;
+        foreach (int from, capturers) {
+            search.reset(from, _pos.kings.test(from));
+
+            if (!Rules::MAXIMUM_CAPTURE) {
+                finishCaptures(from, BitBoard(), search, opp, moves, true);
+                continue;
+            }
+
+            // a pawn only has a handful of ways to capture, memoizing pays
+            // off for kings which may have exponentially many
+            int longest = -1;
+            if (search.king) {
+                while ((longest = longestCapture(from, BitBoard(), search, opp)) < 0 && search.grow()) {
+                    search.reset(from, true);
+                }
+            }
+            if (longest < 0) {
+                // the table only remembers the ends of the captures now
+                search.reset(from, search.king);
+                walkCaptures(from, BitBoard(), search, opp, moves, maxTaken);
+                continue;
+            }
+            if (longest < maxTaken) continue;
+            if (longest > maxTaken) {
+                moves.clear();
+                maxTaken = longest;
+            }
+            collectCaptures(from, BitBoard(), longest, search, opp, moves);
+        }
+    }
+}
+
+template<int Radius, class Rules>
+template<Color Us>
+void
+BasicMoveGenerator<Radius, Rules>::validQuietMoves(MoveList &moves) const
+{
+    moves.clear();
+
+    const BitBoard &own = Us == White ? _pos.white : _pos.black;
+    const BitBoard empty = ~(_pos.white | _pos.black);
+
+    // shift all pawns one step at a time, the origin is the inverse shift
+    const BitBoard pawns = own & ~_pos.kings;
+    const int d_min = Us == White ? Grid::NorthWest : Grid::SouthEast;
+    for (int d = d_min; d < d_min + 3; ++d) {
+        for (int i = 0; i < Grid::_tables.shiftCount[d]; ++i) {
+            const typename Grid::Tables::Shift &sh = Grid::_tables.shifts[d][i];
+            foreach (int to, (pawns & sh.from).shifted(sh.amount) & empty) {
+                moves << MoveBit(to - sh.amount, to);
+            }
+        }
+    }
+
+    // kings fly in every direction up to the first piece
+    foreach (int from, own & _pos.kings) {
+        if (!Rules::FLYING_KINGS) {
+            // or step to any neighbour
+            foreach (int to, (Grid::_tables.northMasks[from] | Grid::_tables.southMasks[from]) & empty) {
+                moves << MoveBit(from, to);
+            }
+            continue;
+        }
+        for (int d = 0; d < 6; ++d) {
+            BitBoard dests = Grid::_tables.rayMasks[from][d];
+            const BitBoard stops = dests & ~empty;
+            if (stops.any()) {
+                int stop = Grid::firstAlongRay(stops, d);
+                dests &= ~(Grid::_tables.rayMasks[stop][d] | BitBoard::square(stop));
+            }
+            foreach (int to, dests) {
+                moves << MoveBit(from, to);
+            }
+        }
+    }
+}
+
+template<int Radius, class Rules>
+template<Color Us>
+typename BasicMoveGenerator<Radius, Rules>::BitBoard
+BasicMoveGenerator<Radius, Rules>::capturingPieces() const
+{
+    const BitBoard &cur = Us == White ? _pos.white : _pos.black;
+    const BitBoard &opp = Us == White ? _pos.black : _pos.white;
+    const BitBoard empty = ~(_pos.white | _pos.black);
+
+    // pawns, and kings that don't fly: an opponent next to us with an empty
+    // cell behind it
+    BitBoard capturers;
+    for (int d = 0; d < 6; ++d) {
+        const int back = Grid::opposite(d);
+        BitBoard found = Grid::shift(opp & Grid::shift(empty, back), back);
+        if (!Rules::PAWNS_CAPTURE_BACKWARDS && !forward(Us, d))
+            found &= _pos.kings;
+        capturers |= found;
+    }
+    capturers &= Rules::FLYING_KINGS ? cur & ~_pos.kings : cur;
+    if (!Rules::FLYING_KINGS)
+        return capturers;
+
+    // kings: the first piece along a ray is an opponent with an empty cell behind it
+    foreach (int from, cur & _pos.kings) {
+        for (int d = 0; d < 6; ++d) {
+            const BitBoard blockers = Grid::_tables.rayMasks[from][d] & ~empty;
+            if (blockers.none()) continue;
+            int over = Grid::firstAlongRay(blockers, d);
+            if (opp.test(over) && (Grid::shift(BitBoard::square(over), d) & empty).any()) {
+                capturers.set(from);
+                break;
+            }
+        }
+    }
+
+    return capturers;
+}
+
+template<int Radius, class Rules>
+template<Color Us>
+bool
+BasicMoveGenerator<Radius, Rules>::hasMoves() const
+{
+    const BitBoard &own = Us == White ? _pos.white : _pos.black;
+    const BitBoard empty = ~(_pos.white | _pos.black);
+
+    // every piece that can move at all can step to an empty neighbour, pawns
+    // only forwards
+    for (int d = 0; d < 6; ++d) {
+        const BitBoard movers = forward(Us, d) ? own : own & _pos.kings;
+        if ((movers & Grid::shift(empty, Grid::opposite(d))).any()) return true;
+    }
+
+    // or is blocked by pieces it can capture
+    return capturingPieces<Us>().any();
+}
+
+template<int Radius, class Rules>
+template<Color Us>
+bool
+BasicMoveGenerator<Radius, Rules>::isPlausible(const MoveBit &move) const
+{
+    const BitBoard &own = Us == White ? _pos.white : _pos.black;
+    const BitBoard &opp = Us == White ? _pos.black : _pos.white;
+    const BitBoard occupied = _pos.white | _pos.black;
+
+    // one of our pieces moving to an empty cell
+    const int f = move.from();
+    const int t = move.to();
+    if (f >= BitBoard::SIZE || t >= BitBoard::SIZE) return false;
+    if (!own.test(f) || occupied.test(t)) return false;
+
+    if (move.isCapture()) {
+        if ((move.taken() & ~opp).any()) return false;
+        if (!capturingPieces<Us>().test(f)) return false;
+
+        MoveList captures;
+        validCaptures<Us>(captures);
+        return captures.contains(move);
+    }
+
+    // captures are mandatory
+    if (capturingPieces<Us>().any()) return false;
+
+    if (!_pos.kings.test(f)) {
+        const BitBoard &forward = Us == White ? Grid::_tables.northMasks[f] : Grid::_tables.southMasks[f];
+        return forward.test(t);
+    }
+
+    if (!Rules::FLYING_KINGS)
+        return (Grid::_tables.northMasks[f] | Grid::_tables.southMasks[f]).test(t);
+
+    // kings may fly, but not over other pieces
+    for (int d = 0; d < 6; ++d) {
+        if (!Grid::_tables.rayMasks[f][d].test(t)) continue;
+        const BitBoard between = Grid::_tables.rayMasks[f][d] & ~Grid::_tables.rayMasks[t][d] & ~BitBoard::square(t);
+        return (between & occupied).none();
+    }
+    return false;
+}
+
+template<int Radius, class Rules>
+QList<Move>
+BasicMoveGenerator<Radius, Rules>::paths(const MoveBit &move) const
+{
+    Move path;
+    path.path << Grid::coord(move.from());
+    if (!move.isCapture()) {
+        path.path << Grid::coord(move.to());
+        return QList<Move>() << path;
+    }
+
+    CaptureSearch search;
+    search.from = move.from();
+    search.king = _pos.kings.test(move.from());
+    const BitBoard &opp = _pos.white.test(move.from()) ? _pos.black : _pos.white;
+
+    QList<Move> paths;
+    walkPaths(move.from(), BitBoard(), move, search, opp, path, paths);
+    return paths;
+}
+
+namespace
+{
+/**
+ * The rules played out cell by cell over the coordinates of the grid, as an
+ * oracle for the generator.
+ *
+ * Shares nothing with it but the Position and the cell numbering: the
+ * neighbours, rays and jumps are stepped out here instead of coming from
+ * GridTables, so a wrong table shows up as a difference. Exponential for
+ * kings with many captures.
+ */
+template<int Radius, class Rules>
+class ReferenceGenerator
+{
+public:
+    typedef BasicMoveGenerator<Radius, Rules> Generator;
+    typedef typename Generator::BitBoard BitBoard;
+    typedef typename Generator::MoveBit MoveBit;
+    typedef typename Generator::MoveList MoveList;
+    typedef typename Generator::Position Position;
+
+    ReferenceGenerator(const Position &pos, Color col) : _pos(pos), _col(col) { }
+
+    void moves(MoveList &moves) const
+    {
+        moves.clear();
+        int longest = 1;
+        for (int x = 0; x < SIZE; ++x) {
+            for (int y = 0; y < SIZE; ++y) {
+                if (own(x, y)) captures(x, y, x, y, BitBoard(), longest, moves);
+            }
+        }
+        if (!moves.empty()) return;
+
+        for (int x = 0; x < SIZE; ++x) {
+            for (int y = 0; y < SIZE; ++y) {
+                if (own(x, y)) quietMoves(x, y, moves);
+            }
+        }
+    }
+
+private:
+    static const int SIZE = 2 * Radius + 1;
+
+    // cells counted over x then y, each column starts where the hexagon does
+    static int index(int x, int y)
+    {
+        if (x < 0 || y < 0 || x >= SIZE || y >= SIZE || qAbs(x - y) > Radius) return -1;
+        int idx = 0;
+        for (int i = 0; i < x; ++i) {
+            idx += qMin(SIZE - 1, i + Radius) - qMax(0, i - Radius) + 1;
+        }
+        return idx + y - qMax(0, x - Radius);
+    }
+
+    // NorthWest, North, NorthEast, SouthEast, South, SouthWest
+    static int dx(int d) { static const int v[6] = {1, 1, 0, 0, -1, -1}; return v[d]; }
+    static int dy(int d) { static const int v[6] = {0, 1, 1, -1, -1, 0}; return v[d]; }
+    bool forward(int d) const { return _col == White ? d < 3 : d >= 3; }
+
+    bool own(int x, int y) const
+    {
+        const int i = index(x, y);
+        return i >= 0 && (_col == White ? _pos.white : _pos.black).test(i);
+    }
+    bool opp(int x, int y) const
+    {
+        const int i = index(x, y);
+        return i >= 0 && (_col == White ? _pos.black : _pos.white).test(i);
+    }
+    // the moving piece still counts as standing on its origin
+    bool empty(int x, int y) const
+    {
+        const int i = index(x, y);
+        return i >= 0 && !_pos.white.test(i) && !_pos.black.test(i);
+    }
+    bool flies(int fx, int fy) const { return Rules::FLYING_KINGS && _pos.kings.test(index(fx, fy)); }
+
+    // every capture of the piece from (fx, fy) continuing from (x, y), only
+    // those taking at least longest pieces if the longest have to be played
+    void captures(int fx, int fy, int x, int y, const BitBoard &taken, int &longest, MoveList &moves) const
+    {
+        const bool king = _pos.kings.test(index(fx, fy));
+        bool jumped = false;
+        for (int d = 0; d < 6; ++d) {
+            if (!king && !Rules::PAWNS_CAPTURE_BACKWARDS && !forward(d)) continue;
+
+            // skip the empty cells in front of a flying king
+            int ox = x + dx(d);
+            int oy = y + dy(d);
+            while (flies(fx, fy) && empty(ox, oy)) {
+                ox += dx(d);
+                oy += dy(d);
+            }
+            if (!opp(ox, oy) || taken.test(index(ox, oy))) continue;
+
+            BitBoard t(taken);
+            t.set(index(ox, oy));
+            for (int n = 1; empty(ox + n * dx(d), oy + n * dy(d)); ++n) {
+                jumped = true;
+                captures(fx, fy, ox + n * dx(d), oy + n * dy(d), t, longest, moves);
+                if (!flies(fx, fy)) break;
+            }
+        }
+
+        if (jumped || taken.none()) return;
+        if (Rules::MAXIMUM_CAPTURE) {
+            if (taken.count() < longest) return;
+            if (taken.count() > longest) {
+                moves.clear();
+                longest = taken.count();
+            }
+        }
+        const MoveBit m(index(fx, fy), index(x, y), taken);
+        if (!moves.contains(m))
+            moves << m;
+    }
+
+    void quietMoves(int x, int y, MoveList &moves) const
+    {
+        const bool king = _pos.kings.test(index(x, y));
+        for (int d = 0; d < 6; ++d) {
+            if (!king && !forward(d)) continue;
+            for (int n = 1; empty(x + n * dx(d), y + n * dy(d)); ++n) {
+                moves << MoveBit(index(x, y), index(x + n * dx(d), y + n * dy(d)));
+                if (!king || !Rules::FLYING_KINGS) break;
+            }
+        }
+    }
+
+    const Position &_pos;
+    const Color _col;
+};
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::referenceMoves(Color col, MoveList &moves) const
+{
+    ReferenceGenerator<Radius, Rules>(_pos, col).moves(moves);
+}
+
+template<int Radius, class Rules>
+BasicMoveGenerator<Radius, Rules>::CaptureSearch::CaptureSearch()
+    : from(0)
+    , king(false)
+    , stamp(0)
+    , bits(SMALL_BITS)
+    , load(0)
+    , table(small)
+{
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::CaptureSearch::reset(quint8 from, bool king)
+{
+    this->from = from;
+    this->king = king;
+    if (!king) return; // pawns don't use the table
+
+    // clear the table the first time it is used, after that bumping the
+    // stamp invalidates every entry without touching it
+    if (stamp == 0)
+        std::memset(small, 0, sizeof(small));
+    ++stamp;
+    load = 0;
+}
+
+template<int Radius, class Rules>
+typename BasicMoveGenerator<Radius, Rules>::CaptureSearch::State *
+BasicMoveGenerator<Radius, Rules>::CaptureSearch::find(quint8 at, const BitBoard &taken)
+{
+    quint64 key = (BitOps::fold(taken.word()) ^ (quint64(at) << 57)) * Q_UINT64_C(0x9e3779b97f4a7c15);
+    const int mask = (1 << bits) - 1;
+    int i = key >> (64 - bits);
+    while (table[i].stamp == stamp) {
+        if (table[i].at == at && table[i].taken == taken.word()) return &table[i];
+        i = (i + 1) & mask;
+    }
+    if (load == (1 << bits) * 3 / 4) return 0;
+
+    ++load;
+    State &state = table[i];
+    state.taken = taken.word();
+    state.stamp = stamp;
+    state.at = at;
+    state.longest = -1;
+    state.expanded = false;
+    state.ended = false;
+    return &state;
+}
+
+template<int Radius, class Rules>
+bool
+BasicMoveGenerator<Radius, Rules>::CaptureSearch::grow()
+{
+    if (bits >= MAX_BITS) return false;
+
+    bits += 2;
+    large.resize(1 << bits);
+    table = large.data();
+    std::memset(table, 0, (1 << bits) * sizeof(State));
+    load = 0;
+    return true;
+}
+
+template<int Radius, class Rules>
+int
+BasicMoveGenerator<Radius, Rules>::jumps(quint8 at, const BitBoard &taken, const CaptureSearch &search, const BitBoard &opp, Jump *out) const
+{
+    // the origin counts as occupied, the piece may not pass over it again
+    const BitBoard occupied = _pos.white | _pos.black;
+    int n = 0;
+
+    if (!search.king || !Rules::FLYING_KINGS) {
+        // may not jump
+        if ((opp & Grid::_tables.neighbourMasks[at]).none()) return 0;
+
+        int begin = 0;
+        int end = 6;
+        if (!Rules::PAWNS_CAPTURE_BACKWARDS && !search.king) {
+            begin = _pos.white.test(search.from) ? Grid::NorthWest : Grid::SouthEast;
+            end = begin + 3;
+        }
+        for (int d = begin; d < end; ++d) {
+            const BitBoard &jump = Grid::_tables.pawnJumpMasks[at][d];
+            if ((opp & jump).none()) continue; // can't jump in direction d
+            if ((taken & jump).any()) continue; // already took piece
+            int to = (jump & ~Grid::_tables.neighbourMasks[at]).first();
+            if (occupied.test(to)) continue; // dest is not free
+
+            out[n].over = (jump & Grid::_tables.neighbourMasks[at]).first();
+            out[n].to = to;
+            ++n;
+        }
+    } else {
+        for (int d = 0; d < 6; ++d) {
+            if ((opp & Grid::_tables.kingJumpMasks[at][d]).none()) continue; // can't jump in direction d
+
+            // the first piece along the ray has to be an opponent's
+            const BitBoard blockers = Grid::_tables.rayMasks[at][d] & occupied;
+            if (blockers.none()) continue;
+            int over = Grid::firstAlongRay(blockers, d);
+            if (!opp.test(over)) continue;
+            if (taken.test(over)) continue; // already took piece
+
+            // we may land anywhere behind it, up to the next piece
+            BitBoard dests = Grid::_tables.rayMasks[over][d];
+            const BitBoard stops = dests & occupied;
+            if (stops.any()) {
+                int stop = Grid::firstAlongRay(stops, d);
+                dests &= ~(Grid::_tables.rayMasks[stop][d] | BitBoard::square(stop));
+            }
+
+            foreach (int to, dests) {
+                out[n].over = over;
+                out[n].to = to;
+                ++n;
+            }
+        }
+    }
+    Q_ASSERT(n <= MAX_JUMPS);
+
+    return n;
+}
+
+template<int Radius, class Rules>
+int
+BasicMoveGenerator<Radius, Rules>::longestCapture(quint8 at, const BitBoard &taken, CaptureSearch &search, const BitBoard &opp) const
+{
+    typename CaptureSearch::State *state = search.find(at, taken);
+    if (!state) return -1;
+    if (state->longest >= 0) return state->longest;
+
+    Jump next[MAX_JUMPS];
+    int n = jumps(at, taken, search, opp, next);
+    int longest = 0;
+    for (int i = 0; i < n; ++i) {
+        BitBoard t = taken | BitBoard::square(next[i].over);
+        int l = longestCapture(next[i].to, t, search, opp);
+        if (l < 0) return -1;
+        longest = qMax(longest, 1 + l);
+    }
+
+    state->longest = longest;
+    return longest;
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::collectCaptures(quint8 at, const BitBoard &taken, int remaining,
+                               CaptureSearch &search, const BitBoard &opp, MoveList &moves) const
+{
+    // reaching a state again can only yield the same moves
+    typename CaptureSearch::State *state = search.find(at, taken);
+    Q_ASSERT(state); // longestCapture already visited it
+    if (state->expanded) return;
+    state->expanded = true;
+
+    if (remaining == 0) {
+        moves << MoveBit(search.from, at, taken);
+        return;
+    }
+
+    // only follow captures that still lead to a longest one
+    Jump next[MAX_JUMPS];
+    int n = jumps(at, taken, search, opp, next);
+    for (int i = 0; i < n; ++i) {
+        BitBoard t = taken | BitBoard::square(next[i].over);
+        if (longestCapture(next[i].to, t, search, opp) == remaining - 1)
+            collectCaptures(next[i].to, t, remaining - 1, search, opp, moves);
+    }
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::walkCaptures(quint8 at, const BitBoard &taken, CaptureSearch &search,
+                            const BitBoard &opp, MoveList &moves, int &maxTaken) const
+{
+    Jump next[MAX_JUMPS];
+    int n = jumps(at, taken, search, opp, next);
+    for (int i = 0; i < n; ++i) {
+        BitBoard t = taken | BitBoard::square(next[i].over);
+
+        int s = t.count();
+        if (s >= maxTaken) {
+            if (s > maxTaken) {
+                moves.clear();
+                maxTaken = s;
+            }
+            MoveBit m(search.from, next[i].to, t);
+            if (!appended(next[i].to, t, search, moves))
+                moves << m;
+        }
+
+        walkCaptures(next[i].to, t, search, opp, moves, maxTaken);
+    }
+}
+
+template<int Radius, class Rules>
+bool
+BasicMoveGenerator<Radius, Rules>::appended(quint8 to, const BitBoard &taken, CaptureSearch &search,
+                                            const MoveList &moves) const
+{
+    // a king marks the ends it reached in its table, it may reach hundreds
+    if (search.king) {
+        typename CaptureSearch::State *state = search.find(to, taken);
+        if (state) {
+            const bool seen = state->ended;
+            state->ended = true;
+            return seen;
+        }
+    }
+
+    // else the moves of this piece are the last ones of the list
+    const MoveBit m(search.from, to, taken);
+    for (int i = moves.size() - 1; i >= 0 && moves[i].from() == search.from; --i) {
+        if (moves[i] == m) return true;
+    }
+    return false;
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::finishCaptures(quint8 at, const BitBoard &taken, CaptureSearch &search,
+                                                  const BitBoard &opp, MoveList &moves, bool memoize) const
+{
+    // a king may reach the same state in many orders, expand it only once
+    if (memoize && search.king) {
+        typename CaptureSearch::State *state = search.find(at, taken);
+        if (state) {
+            if (state->expanded) return;
+            state->expanded = true;
+        }
+    }
+
+    Jump next[MAX_JUMPS];
+    int n = jumps(at, taken, search, opp, next);
+    if (n == 0) {
+        // a pawn may still get here twice
+        if (taken.any() && !appended(at, taken, search, moves))
+            moves << MoveBit(search.from, at, taken);
+        return;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        finishCaptures(next[i].to, taken | BitBoard::square(next[i].over), search, opp, moves, memoize);
+    }
+}
+
+template<int Radius, class Rules>
+void
+BasicMoveGenerator<Radius, Rules>::walkPaths(quint8 at, const BitBoard &taken, const MoveBit &move, const CaptureSearch &search,
+                         const BitBoard &opp, Move &path, QList<Move> &paths) const
+{
+    if (taken == move.taken()) {
+        if (at == move.to()) paths << path;
+        return;
+    }
+
+    Jump next[MAX_JUMPS];
+    int n = jumps(at, taken, search, opp, next);
+    for (int i = 0; i < n; ++i) {
+        if (!move.taken().test(next[i].over)) continue; // not part of this move
+
+        path.path << Grid::coord(next[i].to);
+        path.taken << Grid::coord(next[i].over);
+        walkPaths(next[i].to, taken | BitBoard::square(next[i].over), move, search, opp, path, paths);
+        path.path.removeLast();
+        path.taken.removeLast();
+    }
+}
+
+template class BasicMoveGenerator<4>;
+template class BasicMoveGenerator<5>;
+template class BasicMoveGenerator<6>;
+template class BasicMoveGenerator<4, FreeCaptureRules>;
+template class BasicMoveGenerator<4, ShortKingRules>;
+template class BasicMoveGenerator<4, ForwardCaptureRules>;
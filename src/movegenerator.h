@@ -0,0 +1,169 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MOVEGENERATOR_H
+#define MOVEGENERATOR_H
+
+#include "hexdamegrid.h"
+
+/**
+ * Computes the valid moves of a grid, following its Rules.
+ *
+ * Keeps the move generation code out of HexdameGrid so the grid stays a
+ * plain Position. The generator only reads the grid, all search state lives
+ * on the stack of the call and results go into buffers owned by the caller,
+ * so any number of threads may generate moves at the same time. It must not
+ * outlive the grid it was created from.
+ */
+template<int Radius, class Rules>
+class BasicMoveGenerator
+{
+public:
+    typedef BasicHexdameGrid<Radius, Rules> Grid;
+    typedef typename Grid::BitBoard BitBoard;
+    typedef typename Grid::MoveBit MoveBit;
+    typedef typename Grid::MoveList MoveList;
+    typedef typename Grid::Position Position;
+
+    explicit BasicMoveGenerator(const Grid &grid);
+
+    void validMoveBits(Color col, MoveList &moves) const;
+    // the longest captures, empty if col can't capture
+    void validCaptures(Color col, MoveList &moves) const;
+    // moves that don't capture, only valid if col can't capture
+    void validQuietMoves(Color col, MoveList &moves) const;
+    // pieces of colour col that have at least one capture available
+    BitBoard capturingPieces(Color col) const;
+    // whether col has any move at all, without generating them
+    bool hasMoves(Color col) const;
+
+    /**
+     * Whether move can be played by col, meant for moves coming out of the
+     * transposition table which might belong to another position.
+     *
+     * Quiet moves are checked without generating anything. A capture that
+     * passes the cheap checks is looked up among the valid captures, its
+     * path and length can't be told apart from the bits alone.
+     */
+    bool isPlausible(Color col, const MoveBit &move) const;
+
+    // every sequence of jumps that makes up move, for display
+    QList<Move> paths(const MoveBit &move) const;
+
+    // same moves as validMoveBits, stepped out over the coordinates without
+    // any of the tables of the grid, slow and only meant to check the former
+    void referenceMoves(Color col, MoveList &moves) const;
+
+private:
+    // the above with the side to move known at compile time, so the colour
+    // picks its boards and directions once instead of in every loop
+    template<Color Us> void validMoveBits(MoveList &moves) const;
+    template<Color Us> void validCaptures(MoveList &moves) const;
+    template<Color Us> void validQuietMoves(MoveList &moves) const;
+    template<Color Us> BitBoard capturingPieces() const;
+    template<Color Us> bool hasMoves() const;
+    template<Color Us> bool isPlausible(const MoveBit &move) const;
+
+    // a single capture: the piece jumps over `over` and lands on `to`
+    struct Jump {
+        quint8 over;
+        quint8 to;
+    };
+    // a king has at most 6 directions with a landing cell on all but two
+    // cells of each
+    static const int MAX_JUMPS = 6 * (Grid::Tables::SIZE - 2);
+
+    /**
+     * Capture search of a single piece.
+     *
+     * Where a king can go next only depends on the cell it stands on and
+     * the pieces it took so far, since captured pieces stay on the board
+     * until the move is done. Those states are memoized in an open addressing
+     * table, so every state is expanded at most once no matter in how many
+     * orders its pieces can be taken. The table starts small enough to be
+     * cheap to clear and moves to the heap for the rare pieces that need more.
+     */
+    struct CaptureSearch {
+        struct State {
+            typename BitBoard::Word taken;
+            quint32 stamp;  // search the entry belongs to, stale otherwise
+            quint8 at;
+            qint8 longest;  // most captures still possible from here, -1 if unknown
+            bool expanded;  // its longest captures have been collected
+            bool ended;     // a capture ending here has been appended
+        };
+        static const int SMALL_BITS = 8;
+        static const int MAX_BITS = 16;
+
+        CaptureSearch();
+        // starts over for the piece on from
+        void reset(quint8 from, bool king);
+        // entry of (at, taken), 0 if the table is too full to add it
+        State *find(quint8 at, const BitBoard &taken);
+        // moves to a larger table, false if it is as large as it gets
+        bool grow();
+
+        quint8 from;
+        bool king;
+        quint32 stamp;
+        int bits;
+        int load;
+        State *table;
+        State small[1 << SMALL_BITS];
+        QVector<State> large;
+
+    private:
+        Q_DISABLE_COPY(CaptureSearch)
+    };
+
+    int jumps(quint8 at, const BitBoard &taken, const CaptureSearch &search, const BitBoard &opp, Jump *out) const;
+    // most captures possible from (at, taken), -1 if the table overflowed
+    int longestCapture(quint8 at, const BitBoard &taken, CaptureSearch &search, const BitBoard &opp) const;
+    // appends the captures of exactly remaining more pieces from (at, taken)
+    void collectCaptures(quint8 at, const BitBoard &taken, int remaining,
+                         CaptureSearch &search, const BitBoard &opp, MoveList &moves) const;
+    // appends every longest capture without memoizing, for pawns and huge searches
+    void walkCaptures(quint8 at, const BitBoard &taken, CaptureSearch &search,
+                      const BitBoard &opp, MoveList &moves, int &maxTaken) const;
+    // whether the capture of taken ending on to is in moves already
+    bool appended(quint8 to, const BitBoard &taken, CaptureSearch &search, const MoveList &moves) const;
+    // appends every capture from (at, taken) that goes on until nothing is
+    // left to take, for rules that don't insist on the longest one
+    void finishCaptures(quint8 at, const BitBoard &taken, CaptureSearch &search,
+                        const BitBoard &opp, MoveList &moves, bool memoize) const;
+    void walkPaths(quint8 at, const BitBoard &taken, const MoveBit &move, const CaptureSearch &search,
+                   const BitBoard &opp, Move &path, QList<Move> &paths) const;
+
+    // whether d leads towards the side where col's pawns become kings
+    static bool forward(Color col, int d) { return col == White ? d <= Grid::NorthEast : d >= Grid::SouthEast; }
+
+    const Grid &_grid;
+    const Position &_pos;
+};
+
+extern template class BasicMoveGenerator<4>;
+extern template class BasicMoveGenerator<5>;
+extern template class BasicMoveGenerator<6>;
+extern template class BasicMoveGenerator<4, FreeCaptureRules>;
+extern template class BasicMoveGenerator<4, ShortKingRules>;
+extern template class BasicMoveGenerator<4, ForwardCaptureRules>;
+
+typedef BasicMoveGenerator<4> MoveGenerator;
+
+#endif // MOVEGENERATOR_H
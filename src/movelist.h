@@ -0,0 +1,140 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MOVELIST_H
+#define MOVELIST_H
+
+#include "commondefs.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#include <QtDebug> // needed for Q_ASSERT
+
+/**
+ * List of moves with a score attached to each of them.
+ *
+ * Meant to live on the stack of the search, the first Capacity moves are
+ * stored inline. Some positions have more moves than that (kings capturing
+ * freely can take the same pieces in hundreds of orders), the list then
+ * moves to the heap rather than dropping any. Don't pass it to foreach,
+ * that would copy the whole array.
+ */
+template<class M, int Capacity = 256>
+class BasicMoveList
+{
+public:
+    typedef M MoveBit;
+    static const int CAPACITY = Capacity;
+
+    BasicMoveList() : _heapMoves(0), _heapScores(0), _size(0), _capacity(CAPACITY) { }
+    BasicMoveList(const BasicMoveList &other)
+        : _heapMoves(0), _heapScores(0), _size(0), _capacity(CAPACITY) { *this = other; }
+    ~BasicMoveList() { release(); }
+
+    BasicMoveList &operator=(const BasicMoveList &other) {
+        if (this == &other) return *this;
+        _size = 0;
+        while (_capacity < other._size) grow();
+        std::copy(other.moves(), other.moves() + other._size, moves());
+        std::copy(other.scores(), other.scores() + other._size, scores());
+        _size = other._size;
+        return *this;
+    }
+
+    inline int size() const { return _size; }
+    inline bool empty() const { return _size == 0; }
+    inline void clear() { _size = 0; }
+
+    inline const MoveBit &at(int i) const { Q_ASSERT(i < _size); return moves()[i]; }
+    inline const MoveBit &operator[](int i) const { return at(i); }
+    inline int score(int i) const { Q_ASSERT(i < _size); return scores()[i]; }
+    inline void setScore(int i, int score) { Q_ASSERT(i < _size); scores()[i] = score; }
+
+    inline void append(const MoveBit &m, int score = 0) {
+        if (_size == _capacity) grow();
+        moves()[_size] = m;
+        scores()[_size] = score;
+        ++_size;
+    }
+    inline BasicMoveList &operator<<(const MoveBit &m) { append(m); return *this; }
+
+    int indexOf(const MoveBit &m) const {
+        for (int i = 0; i < _size; ++i) {
+            if (moves()[i] == m) return i;
+        }
+        return -1;
+    }
+    inline bool contains(const MoveBit &m) const { return indexOf(m) >= 0; }
+
+    // swaps the best scored move of [i, size) into i, call it once per move
+    // instead of sorting the whole list since we often cut off early
+    void pickBest(int i) {
+        int best = i;
+        for (int j = i + 1; j < _size; ++j) {
+            if (scores()[j] > scores()[best]) best = j;
+        }
+        if (best != i) {
+            qSwap(moves()[i], moves()[best]);
+            qSwap(scores()[i], scores()[best]);
+        }
+    }
+
+private:
+    // MoveBit zeroes itself on construction, keep the storage raw so
+    // creating a list doesn't touch all of it
+    inline MoveBit *moves() {
+        return _heapMoves ? _heapMoves : reinterpret_cast<MoveBit *>(_moves);
+    }
+    inline const MoveBit *moves() const {
+        return _heapMoves ? _heapMoves : reinterpret_cast<const MoveBit *>(_moves);
+    }
+    inline int *scores() { return _heapScores ? _heapScores : _scores; }
+    inline const int *scores() const { return _heapScores ? _heapScores : _scores; }
+
+    // doubles the room, only reached by the rare lists past CAPACITY
+    void grow() {
+        const int capacity = 2 * _capacity;
+        MoveBit *heapMoves = new MoveBit[capacity];
+        int *heapScores = new int[capacity];
+        std::copy(moves(), moves() + _size, heapMoves);
+        std::copy(scores(), scores() + _size, heapScores);
+        release();
+        _heapMoves = heapMoves;
+        _heapScores = heapScores;
+        _capacity = capacity;
+    }
+    void release() {
+        delete[] _heapMoves;
+        delete[] _heapScores;
+        _heapMoves = 0;
+        _heapScores = 0;
+    }
+
+    typename std::aligned_storage<sizeof(MoveBit), alignof(MoveBit)>::type _moves[CAPACITY];
+    int _scores[CAPACITY];
+    MoveBit *_heapMoves;
+    int *_heapScores;
+    int _size;
+    int _capacity;
+};
+
+typedef BasicMoveList<MoveBit> MoveList;
+
+#endif // MOVELIST_H
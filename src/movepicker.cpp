@@ -0,0 +1,79 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "movepicker.h"
+
+MovePicker::MovePicker(const HexdameGrid &grid, Color col, const MoveBit &ttMove, MoveCache *cache)
+    : _grid(grid)
+    , _generator(grid)
+    , _cache(cache)
+    , _col(col)
+    , _ttMove(ttMove)
+    , _stage(TTMove)
+    , _cur(0)
+{
+}
+
+bool
+MovePicker::next(MoveBit &move)
+{
+    if (_stage == TTMove) {
+        _stage = Captures;
+        // it might be left over from another position with the same hash
+        if (_ttMove.isCapture()) {
+            generateCaptures();
+            if (_moves.contains(_ttMove)) {
+                move = _ttMove;
+                return true;
+            }
+        } else if (!_ttMove.empty() && _generator.isPlausible(_col, _ttMove)) {
+            move = _ttMove;
+            return true;
+        }
+        _ttMove = MoveBit();
+    }
+    if (_stage == Captures) {
+        generateCaptures();
+    }
+    if (_stage == QuietMoves) {
+        // captures are mandatory, only look for other moves if there are none
+        _generator.validQuietMoves(_col, _moves);
+        _stage = Remaining;
+    }
+
+    while (_cur < _moves.size()) {
+        const MoveBit &m = _moves.at(_cur++);
+        if (m == _ttMove) continue; // already tried it first
+        move = m;
+        return true;
+    }
+    return false;
+}
+
+void
+MovePicker::generateCaptures()
+{
+    if (_cache) {
+        _cache->validMoves(_grid, _col, _moves);
+        _stage = Remaining;
+        return;
+    }
+    _generator.validCaptures(_col, _moves);
+    _stage = _moves.empty() ? QuietMoves : Remaining;
+}
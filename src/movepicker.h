@@ -0,0 +1,67 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+#include "movecache.h"
+#include "movegenerator.h"
+
+/**
+ * Hands out the moves of a position one at a time, in stages.
+ *
+ * The move from the transposition table is tried first. A quiet one is
+ * checked without generating anything, a capture has to be among the
+ * captures, which are generated first then. Only if it doesn't cause a
+ * cut-off the captures are generated, and the quiet moves only if there are
+ * none. Given a cache, all the moves
+ * come out of it at once instead. The grid may be changed in
+ * between, as long as it is back in the same position when next() is called.
+ */
+class MovePicker
+{
+public:
+    MovePicker(const HexdameGrid &grid, Color col, const MoveBit &ttMove = MoveBit(), MoveCache *cache = 0);
+
+    // the next move to try, false once all of them have been handed out
+    bool next(MoveBit &move);
+
+private:
+    // the captures, or all moves out of the cache, into _moves
+    void generateCaptures();
+
+    enum Stage {
+        TTMove,
+        Captures,
+        QuietMoves,
+        Remaining
+    };
+
+    const HexdameGrid &_grid;
+    MoveGenerator _generator;
+    MoveCache *_cache;
+    Color _col;
+    MoveBit _ttMove;
+    Stage _stage;
+
+    MoveList _moves;
+    int _cur;
+};
+
+#endif // MOVEPICKER_H
@@ -0,0 +1,291 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "perft.h"
+
+#include "batchgenerator.h"
+#include "movegenerator.h"
+#include "player/heuristic.h"
+
+#include <QThread>
+#include <QtDebug>
+
+namespace {
+
+// BatchGenerator only plays the standard game on the 61 cell board
+template<class Grid>
+const char *
+batchError(const Grid &, Color)
+{
+    return 0;
+}
+
+// compares both BatchGenerator paths to MoveGenerator and SomeHeuristic
+const char *
+batchError(const HexdameGrid &grid, Color turn)
+{
+    // a copy in every lane, run only vectorizes whole groups of LANES
+    const int N = BatchGenerator::LANES;
+    const Position &pos = grid.position();
+    quint64 white[N], black[N], kings[N];
+    qint8 side[N];
+    for (int i = 0; i < N; ++i) {
+        white[i] = pos.white.word();
+        black[i] = pos.black.word();
+        kings[i] = pos.kings.word();
+        side[i] = turn;
+    }
+    const BatchGenerator::Positions in = { white, black, kings, side };
+
+    const HexdameGrid::MoveGenerator generator(grid);
+    MoveList quiet;
+    generator.validQuietMoves(turn, quiet);
+    quint64 movers = 0;
+    for (int i = 0; i < quiet.size(); ++i) {
+        movers |= Q_UINT64_C(1) << quiet[i].from();
+    }
+    const quint64 capturers = generator.capturingPieces(turn).word();
+    const int material = SomeHeuristic().value(grid, turn);
+
+    for (int scalar = 0; scalar < 2; ++scalar) {
+        quint64 batchMovers[N], batchDestinations[6 * N], batchCapturers[N];
+        int batchMaterial[N];
+        const BatchGenerator::Results out = { batchMovers, batchDestinations, batchCapturers, batchMaterial };
+        if (scalar) BatchGenerator::runScalar(in, N, out);
+        else BatchGenerator::run(in, N, out);
+
+        for (int l = 0; l < N; ++l) {
+            MoveList batchQuiet;
+            BatchGenerator::quietMoves(in, out, l, batchQuiet);
+            bool same = batchQuiet.size() == quiet.size();
+            for (int i = 0; same && i < quiet.size(); ++i) {
+                same = batchQuiet.contains(quiet[i]);
+            }
+
+            if (batchMovers[l] != movers) return "batch generator movers differ";
+            if (!same) return "batch generator quiet moves differ";
+            if (batchCapturers[l] != capturers) return "batch generator capturers differ";
+            if (batchMaterial[l] != material) return "batch generator material differs";
+        }
+    }
+    return 0;
+}
+
+}
+
+// takes root moves until there are none left
+template<int Radius, class Rules>
+class BasicPerft<Radius, Rules>::Worker : public QThread
+{
+public:
+    Worker(BasicPerft *perft, int depth) : _perft(perft), _depth(depth) { }
+
+    void work()
+    {
+        const int n = _perft->_rootMoves.size();
+        Grid grid(_perft->_root);
+        typename Grid::Undo undo;
+        int i;
+        while ((i = _perft->_next.fetchAndAddRelaxed(1)) < n) {
+            grid.doMove(_perft->_rootMoves[i], undo);
+            _perft->_rootCounts[i] = _perft->count(grid, Color(-_perft->_turn), _depth - 1);
+            grid.undoMove(undo);
+        }
+    }
+
+protected:
+    void run() { work(); }
+
+private:
+    BasicPerft *_perft;
+    int _depth;
+};
+
+template<int Radius, class Rules>
+BasicPerft<Radius, Rules>::BasicPerft(const Grid &grid, Color turn)
+    : _root(grid)
+    , _turn(turn)
+    , _bulk(true)
+    , _check(false)
+    , _threads(1)
+    , _mask(0)
+{
+}
+
+template<int Radius, class Rules>
+void
+BasicPerft<Radius, Rules>::setHashSize(int megabytes)
+{
+    _table.clear();
+    _mask = 0;
+    if (megabytes <= 0) return;
+
+    // largest power of two that fits
+    quint64 entries = 1;
+    while (entries * 2 * sizeof(Entry) <= quint64(megabytes) << 20) {
+        entries *= 2;
+    }
+    _table.fill(Entry(), int(entries));
+    _mask = entries - 1;
+}
+
+template<int Radius, class Rules>
+quint64
+BasicPerft<Radius, Rules>::run(int depth)
+{
+    Q_ASSERT(depth > 0);
+
+    _root.computeValidMoveBits(_turn, _rootMoves);
+    if (_check) check(_root, _turn, _rootMoves);
+
+    _rootCounts.fill(0, _rootMoves.size());
+    _next = 0;
+
+    if (_threads == 1) {
+        Worker(this, depth).work();
+    } else {
+        QList<Worker *> workers;
+        for (int i = 0; i < _threads; ++i) {
+            workers << new Worker(this, depth);
+            workers.last()->start();
+        }
+        foreach (Worker *worker, workers) {
+            worker->wait();
+            delete worker;
+        }
+    }
+
+    quint64 nodes = 0;
+    foreach (quint64 n, _rootCounts) {
+        nodes += n;
+    }
+    return nodes;
+}
+
+template<int Radius, class Rules>
+quint64
+BasicPerft<Radius, Rules>::count(Grid &grid, Color turn, int depth)
+{
+    if (depth == 0) return 1;
+
+    quint64 nodes = 0;
+    if (depth > 1 && probe(grid.zobristHash(), depth, nodes))
+        return nodes;
+
+    MoveList moves;
+    grid.computeValidMoveBits(turn, moves);
+    if (_check) check(grid, turn, moves);
+
+    if (depth == 1 && _bulk) {
+        nodes = moves.size();
+    } else {
+        typename Grid::Undo undo;
+        for (int i = 0; i < moves.size(); ++i) {
+            grid.doMove(moves[i], undo);
+            nodes += count(grid, Color(-turn), depth - 1);
+            grid.undoMove(undo);
+        }
+    }
+
+    if (depth > 1) store(grid.zobristHash(), depth, nodes);
+    return nodes;
+}
+
+template<int Radius, class Rules>
+void
+BasicPerft<Radius, Rules>::check(Grid &grid, Color turn, const MoveList &moves)
+{
+    const typename Grid::MoveGenerator generator(grid);
+    MoveList reference;
+    generator.referenceMoves(turn, reference);
+    bool same = reference.size() == moves.size();
+    for (int i = 0; same && i < moves.size(); ++i) {
+        // every move once, the reference doesn't repeat itself either
+        same = reference.contains(moves[i]) && moves.indexOf(moves[i]) == i;
+    }
+    if (!same) report(grid, turn, "moves differ from the reference generator");
+
+    if (const char *error = batchError(grid, turn))
+        report(grid, turn, error);
+
+    if (grid.zobristHash() != grid.computeHash(turn))
+        report(grid, turn, "incremental hash differs from the computed one");
+
+    const typename Grid::Position before = grid.position();
+    typename Grid::Undo undo;
+    for (int i = 0; i < moves.size(); ++i) {
+        if (grid.movePaths(moves[i]).isEmpty())
+            report(grid, turn, "capture without a path");
+
+        grid.doMove(moves[i], undo);
+        grid.undoMove(undo);
+        if (grid.position() != before || grid.zobristHash() != before.hash) {
+            report(grid, turn, "undoMove doesn't restore the position");
+            grid = Grid(before);
+        }
+    }
+}
+
+template<int Radius, class Rules>
+void
+BasicPerft<Radius, Rules>::report(const Grid &grid, Color turn, const char *what)
+{
+    _errors.fetchAndAddRelaxed(1);
+    qWarning() << "perft:" << what << "in" << grid.toString(turn);
+}
+
+template<int Radius, class Rules>
+bool
+BasicPerft<Radius, Rules>::probe(quint64 hash, int depth, quint64 &nodes) const
+{
+    if (_table.isEmpty()) return false;
+
+    // the same position is counted once per remaining depth
+    const quint64 key = hash ^ (quint64(depth) * Q_UINT64_C(0x9e3779b97f4a7c15));
+    const Entry &entry = _table.at(key & _mask);
+    if ((entry.key ^ entry.nodes) != key) return false;
+
+    nodes = entry.nodes;
+    return true;
+}
+
+template<int Radius, class Rules>
+void
+BasicPerft<Radius, Rules>::store(quint64 hash, int depth, quint64 nodes)
+{
+    if (_table.isEmpty()) return;
+
+    const quint64 key = hash ^ (quint64(depth) * Q_UINT64_C(0x9e3779b97f4a7c15));
+    Entry &entry = _table.data()[key & _mask];
+    entry.key = key ^ nodes;
+    entry.nodes = nodes;
+}
+
+template<int Radius, class Rules>
+QString
+BasicPerft<Radius, Rules>::toString(const MoveBit &move)
+{
+    return QString::number(move.from()) + (move.isCapture() ? 'x' : '-') + QString::number(move.to());
+}
+
+template class BasicPerft<4>;
+template class BasicPerft<5>;
+template class BasicPerft<6>;
+template class BasicPerft<4, FreeCaptureRules>;
+template class BasicPerft<4, ShortKingRules>;
+template class BasicPerft<4, ForwardCaptureRules>;
@@ -0,0 +1,108 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "hexdamegrid.h"
+
+#include <QAtomicInt>
+#include <QVector>
+
+/**
+ * Counts the leaves of the game tree a number of plies below a position.
+ *
+ * Measures the move generator on its own, without any search around it,
+ * and can check it against MoveGenerator::referenceMoves on every node.
+ * The root moves may be split between threads, each with its own grid, and
+ * counts of subtrees may be shared between transpositions through a table.
+ */
+template<int Radius, class Rules = StandardRules>
+class BasicPerft
+{
+public:
+    typedef BasicHexdameGrid<Radius, Rules> Grid;
+    typedef typename Grid::MoveBit MoveBit;
+    typedef typename Grid::MoveList MoveList;
+
+    BasicPerft(const Grid &grid, Color turn);
+
+    // counts the moves of the last ply instead of making them
+    void setBulkCounting(bool bulk) { _bulk = bulk; }
+    // size of the table of subtree counts in megabytes, 0 to go without
+    void setHashSize(int megabytes);
+    void setThreads(int threads) { _threads = qMax(1, threads); }
+    // compares every move list to the reference generator, and for the
+    // standard game BatchGenerator to MoveGenerator, and checks that undoMove
+    // and the incremental hash agree with the position, slow
+    void setCrossCheck(bool check) { _check = check; }
+
+    // leaves depth plies below the position, depth > 0
+    quint64 run(int depth);
+
+    // the moves of the position and the leaves below each of them after run()
+    const MoveList &rootMoves() const { return _rootMoves; }
+    quint64 rootCount(int i) const { return _rootCounts.at(i); }
+    // nodes where the cross check failed
+    int errors() const { return _errors; }
+
+    // from and to cell, separated by 'x' for captures and '-' otherwise
+    static QString toString(const MoveBit &move);
+
+private:
+    class Worker;
+
+    // key is stored xored with nodes, so an entry half written by another
+    // thread doesn't match any position
+    struct Entry {
+        quint64 key;
+        quint64 nodes;
+    };
+
+    quint64 count(Grid &grid, Color turn, int depth);
+    void check(Grid &grid, Color turn, const MoveList &moves);
+    void report(const Grid &grid, Color turn, const char *what);
+
+    bool probe(quint64 hash, int depth, quint64 &nodes) const;
+    void store(quint64 hash, int depth, quint64 nodes);
+
+    Grid _root;
+    Color _turn;
+    bool _bulk;
+    bool _check;
+    int _threads;
+
+    QVector<Entry> _table;
+    quint64 _mask;
+
+    MoveList _rootMoves;
+    QVector<quint64> _rootCounts;
+    QAtomicInt _next;
+    QAtomicInt _errors;
+};
+
+extern template class BasicPerft<4>;
+extern template class BasicPerft<5>;
+extern template class BasicPerft<6>;
+extern template class BasicPerft<4, FreeCaptureRules>;
+extern template class BasicPerft<4, ShortKingRules>;
+extern template class BasicPerft<4, ForwardCaptureRules>;
+
+typedef BasicPerft<4> Perft;
+
+#endif // PERFT_H
@@ -45,7 +45,6 @@ public slots:
     virtual void play() = 0;
 
 signals:
-    void move(const Move &);
     void moveBit(const MoveBit &);
 
 protected:
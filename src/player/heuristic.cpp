@@ -23,26 +23,20 @@
 
 using namespace Hexdame;
 
+const int AbstractHeuristic::WIN;
+
 int SomeHeuristic::value(const HexdameGrid &grid, const int &c) const
 {
-    if (grid.winner() ==  c) return  100;
-    if (grid.winner() == -c) return -100;
-
-    int value = 0;
-    foreach (Coord coord, grid.coords()) {
-        Piece p = grid.at(coord);
-
-        if (isPawn(p) && color(p) ==  c) value+=1;
-        if (isKing(p) && color(p) ==  c) value+=3;
-
-        if (isPawn(p) && color(p) == -c) value-=1;
-        if (isKing(p) && color(p) == -c) value-=3;
+    const Position &pos = grid.position();
+    const BitBoard &own = c == White ? pos.white : pos.black;
+    const BitBoard &opp = c == White ? pos.black : pos.white;
 
-//        if (isPawn(p) && color(p) ==  c) value += qAbs(coord.x - coord.y)/2;
-//        if (isPawn(p) && color(p) == -c) value -= qAbs(coord.x - coord.y)/2;
+    if (opp.none()) return  WIN;
+    if (own.none()) return -WIN;
 
-    }
-    return value;
+    // pawns are worth 1 and kings 3, counted a whole board at a time
+    return own.count() + 2 * (own & pos.kings).count()
+         - opp.count() - 2 * (opp & pos.kings).count();
 }
 
 //int SomeHeuristic::valueWhite(const HexdameGrid &grid) const
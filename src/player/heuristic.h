@@ -21,11 +21,14 @@
 #define HEURISTIC_H
 
 #include "commondefs.h"
+#include "hexdamegrid.h"
 
-class HexdameGrid;
 class AbstractHeuristic
 {
 public:
+    // value of a won game, every other position is worth less
+    static const int WIN = 100;
+
     virtual int value(const HexdameGrid &grid, const int &c) const = 0;
     virtual int valueWhite(const HexdameGrid &grid) const { return value(grid, White); }
 };
@@ -35,7 +35,7 @@ HumanPlayer::play()
 void
 HumanPlayer::moved(Coord from, Coord to)
 {
-    emit move(_move);
+    emit moveBit(_move);
 }
 
 
@@ -38,7 +38,7 @@ protected:
     virtual void run();
 
 private:
-    Move _move;
+    MoveBit _move;
 };
 
 #endif // HUMANPLAYER_H
@@ -21,26 +21,80 @@
 
 #include "heuristic.h"
 #include "hexdamegame.h"
+#include "movepicker.h"
 
 #include <qmath.h>
 #include <QTime>
 #include <QCoreApplication>
+#include <QSettings>
 
 #include <QtDebug>
 #include <QTimer>
 
-MTDfPlayer::MTDfPlayer(HexdameGame *game, Color color, AbstractHeuristic *heuristic)
+const int MTDfPlayer::MAX_DEPTH;
+
+// a null-window search run by a prober on the pool of main
+class MTDfPlayer::Probe : public QRunnable
+{
+public:
+    Probe(MTDfPlayer *main, MTDfPlayer *prober, int depth, int beta)
+        : main(main), prober(prober), depth(depth), beta(beta), value(0), finished(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        const int v = prober->probe(prober->_root, depth, beta);
+        QMutexLocker locker(&main->_probeMutex);
+        value = v;
+        finished = true;
+        main->_probeFinished.wakeAll();
+    }
+
+    MTDfPlayer *main;
+    MTDfPlayer *prober;
+    const int depth;
+    const int beta;
+    int value;
+    bool finished;
+};
+
+MTDfPlayer::MTDfPlayer(HexdameGame *game, Color color, AbstractHeuristic *heuristic, TranspositionTable *ttable)
     : AbstractPlayer(AI, game, color)
+    , ttable(ttable)
+    , _moveCache(QSettings().value("search/movecache", 0).toInt())
     , _heuristic(heuristic)
+    , _threads(qMax(1, QSettings().value("search/threads", 1).toInt()))
+{
+    setProbes(QSettings().value("search/probes", 1).toInt());
+}
+
+// main deletes its helpers itself, they must not be children of the game
+MTDfPlayer::MTDfPlayer(MTDfPlayer *main, int id)
+    : AbstractPlayer(AI, 0, main->_color)
+    , ttable(main->ttable)
+    , _moveCache(QSettings().value("search/movecache", 0).toInt())
+    , _root(main->_root)
+    , _history(main->_history)
+    , _heuristic(main->_heuristic)
+    , nodeCnt(0)
+    , _threads(1)
+    , _main(main)
+    , _id(id)
+    , _probes(1)
 {
-    //FIXME this does not prealocate the underlying hashtable :@
-    // do I really need to subclass QCache?
-    ttable.setMaxCost(500000000);
 }
 
 MTDfPlayer::~MTDfPlayer()
 {
-    delete _heuristic;
+    // helpers share the heuristic of main
+    if (!_main)
+        delete _heuristic;
+    delete _probePool;
+    foreach (MTDfPlayer *prober, _probers) {
+        delete prober;
+    }
 
     mutex.lock();
     abort = true;
@@ -49,35 +103,91 @@ MTDfPlayer::~MTDfPlayer()
     wait();
 }
 
+void
+MTDfPlayer::setProbes(int probes)
+{
+    _probes = qMax(1, probes);
+
+    // the probers and their pool are kept from one search to the next
+    delete _probePool;
+    _probePool = 0;
+    foreach (MTDfPlayer *prober, _probers) {
+        delete prober;
+    }
+    _probers.clear();
+    if (_probes > 1) {
+        _probePool = new QThreadPool;
+        _probePool->setMaxThreadCount(_probes);
+        for (int i = 0; i < _probes; ++i)
+            _probers << new MTDfPlayer(this, _threads + i);
+    }
+}
+
 void
 MTDfPlayer::play()
 {
     QTime tic;
     tic.start();
-    nodeCnt = 0;
-    QList<MoveBit> bestMoves = iterativeDeepening(_game->grid(), tic);
+    QList<MoveBit> bestMoves = search(_game->grid(), _game->history());
     qDebug("%10s %5s %2d %8d %10d", "MTDf", _color == White ? "white" : "black", _depth, nodeCnt, tic.elapsed());
-    qDebug() << ttable.totalCost() << ttable.maxCost();
+    if (_moveCache.enabled()) {
+        const MoveCache::Stats &stats = _moveCache.stats();
+        qDebug("%10s %llu probes, %.1f%% hits, %llu too long", "movecache",
+               stats.probes, 100 * stats.hitRate(), stats.tooLong);
+    }
 
     emit moveBit(bestMoves.at(qrand() % bestMoves.size()));
 }
 
 QList<MoveBit>
-MTDfPlayer::iterativeDeepening(const HexdameGrid& root, QTime tic)
+MTDfPlayer::search(const HexdameGrid &root, const PositionHistory &history, int depth, int msecs)
 {
-    static const int MAX_DEPTH = 25;
+    QTime tic;
+    tic.start();
+    nodeCnt = 0;
+    ttable->newSearch();
+    _root = root;
+    _history = history;
+
+    // Lazy SMP: the helpers search the same root without talking to each
+    // other, only what they leave in the table speeds up the main search
+    QList<MTDfPlayer *> helpers;
+    for (int i = 1; i < _threads; ++i) {
+        helpers << new MTDfPlayer(this, i);
+        helpers.last()->start();
+    }
+    foreach (MTDfPlayer *prober, _probers) {
+        prober->nodeCnt = 0;
+    }
+
+    QList<MoveBit> bestMoves = iterativeDeepening(depth, tic, msecs);
+
+    foreach (MTDfPlayer *prober, _probers) {
+        nodeCnt += prober->nodeCnt;
+    }
 
+    foreach (MTDfPlayer *helper, helpers) {
+        helper->_stop = 1;
+        helper->wait();
+        nodeCnt += helper->nodeCnt;
+        delete helper;
+    }
+    return bestMoves;
+}
+
+QList<MoveBit>
+MTDfPlayer::iterativeDeepening(int maxDepth, QTime tic, int msecs)
+{
     QList<MoveBit> bestMoves;
     int firstguess = 0;
-    for (int d = 0; d <= MAX_DEPTH; ++d) {
+    for (int d = 0; d <= maxDepth; ++d) {
+        _iteration = d;
         int bestValue = INT_MIN;
-        QList<MoveBit> moves = root.computeValidMoveBits(_color);
-        foreach (MoveBit m, moves) {
-            nodeCnt++;
-            HexdameGrid child(root);
-            child.makeMoveBit(m);
-
-            firstguess = _color * mtdf(child, _color*firstguess, d);
+        MoveList moves;
+        _moveCache.validMoves(_root, _color, moves);
+        for (int i = 0; i < moves.size(); ++i) {
+            const MoveBit &m = moves.at(i);
+            firstguess = searchMove(m, firstguess, d);
 
             if (firstguess >= bestValue) {
                 if (firstguess > bestValue) {
@@ -88,20 +198,57 @@ MTDfPlayer::iterativeDeepening(const HexdameGrid& root, QTime tic)
             }
         }
         _depth = d;
-        if (tic.elapsed() >= 6000) break;
+        if (tic.elapsed() >= msecs) break;
     }
     return bestMoves;
 }
 
+void
+MTDfPlayer::helperSearch()
+{
+    MoveList moves;
+    _moveCache.validMoves(_root, _color, moves);
+
+    // half of the helpers search a ply deeper than the main search is at,
+    // the others at its depth, a helper left behind catches up with it and
+    // each starts on another move, so they don't all wait on the same entries
+    int guess = 0;
+    int d = 0;
+    while (!_stop) {
+        d = qMax(d + 1, _main->_iteration + (_id & 1));
+        if (d > MAX_DEPTH) break;
+        for (int i = 0; i < moves.size() && !_stop; ++i) {
+            guess = searchMove(moves.at((i + _id) % moves.size()), guess, d);
+        }
+    }
+}
+
 int
-MTDfPlayer::mtdf(const HexdameGrid& node, int f, int depth)
+MTDfPlayer::searchMove(const MoveBit &m, int guess, int depth)
 {
+    nodeCnt++;
+    HexdameGrid::Undo undo;
+    const bool irreversible = m.isCapture() || _root.isPawn(m.from());
+    _root.doMove(m, undo);
+    _history.push(_root.zobristHash(), irreversible);
+    const int value = _color * mtdf(_root, _color*guess, depth);
+    _history.pop();
+    _root.undoMove(undo);
+    return value;
+}
+
+int
+MTDfPlayer::mtdf(HexdameGrid& node, int f, int depth)
+{
+    if (!_probers.isEmpty())
+        return parallelMtdf(node, f, depth);
+
     int g = f;
     int upperBound = INT_MAX;
     int lowerBound = -INT_MAX;
     while (lowerBound < upperBound) {
         int beta = g == lowerBound ? g+1 : g;
-        g = -_color * negamax(node, depth, beta-1, beta, -_color);
+        g = probe(node, depth, beta);
         (g < beta ? upperBound : lowerBound) = g;
     }
 
@@ -109,48 +256,216 @@ MTDfPlayer::mtdf(const HexdameGrid& node, int f, int depth)
 }
 
 int
-MTDfPlayer::negamax(const HexdameGrid &node, int depth, int alpha, int beta, int color)
+MTDfPlayer::parallelMtdf(HexdameGrid& node, int f, int depth)
+{
+    int g = f;
+    int upperBound = INT_MAX;
+    int lowerBound = -INT_MAX;
+    QVector<Probe *> probes(_probers.size(), 0);
+
+    QMutexLocker locker(&_probeMutex);
+    forever {
+        // any probe narrows the bounds, whatever the order they come back in
+        for (int i = 0; i < probes.size(); ++i) {
+            Probe *p = probes[i];
+            if (!p || !p->finished) continue;
+            // g follows the tightest bound, an older probe may come back
+            // with a weaker one
+            const int value = p->value;
+            if (!_probers[i]->_stop) {
+                if (value < p->beta) {
+                    if (value < upperBound) g = upperBound = value;
+                } else {
+                    if (value > lowerBound) g = lowerBound = value;
+                }
+            }
+            delete p;
+            probes[i] = 0;
+        }
+
+        // a test value outside of the bounds can't tell anything new
+        for (int i = 0; i < probes.size(); ++i) {
+            if (probes[i] && (probes[i]->beta <= lowerBound || probes[i]->beta > upperBound))
+                _probers[i]->_stop = 1;
+        }
+
+        // the value sequential MTD(f) would test next, then those around it
+        const int next = g == lowerBound ? g+1 : g;
+        int step = 0;
+        for (int i = 0; i < probes.size() && lowerBound < upperBound; ++i) {
+            if (probes[i]) continue;
+
+            int beta;
+            bool taken = true;
+            while (taken) {
+                beta = step & 1 ? next + (step + 1) / 2 : next - step / 2;
+                ++step;
+                if (beta <= lowerBound || beta > upperBound) {
+                    if (next + step / 2 > upperBound && next - step / 2 <= lowerBound) break;
+                    continue;
+                }
+                taken = false;
+                foreach (Probe *p, probes) {
+                    if (p && p->beta == beta) taken = true;
+                }
+            }
+            if (taken) break;
+
+            MTDfPlayer *prober = _probers[i];
+            prober->_root = node;
+            prober->_history = _history;
+            prober->_stop = 0;
+            probes[i] = new Probe(this, prober, depth, beta);
+            _probePool->start(probes[i]);
+        }
+
+        bool running = false;
+        foreach (Probe *p, probes) {
+            if (p) running = true;
+        }
+        if (!running) break;
+        _probeFinished.wait(&_probeMutex);
+    }
+
+    return g;
+}
+
+int
+MTDfPlayer::probe(HexdameGrid& node, int depth, int beta)
 {
-    // return an actuall score +-INF or alpha/beta bounds
-    //if (abort) return 0x42;
+    // the opponent is to move and searches for itself, when that is Black the
+    // window [beta-1, beta] seen from White becomes [-beta, 1-beta], not the
+    // same numbers negated afterwards
+    return _color == White ? -negamax<Black>(node, depth, -beta, 1-beta)
+                           :  negamax<White>(node, depth, beta-1, beta);
+}
+
+template<Color Us>
+int
+MTDfPlayer::negamax(HexdameGrid &node, int depth, int alpha, int beta)
+{
+    static const Color Them = Color(-Us);
+
+    // a helper or probe told to stop returns anything, it isn't used
+    if (_stop) return 0;
 
     int alphaOrig = alpha;
     nodeCnt++;
 
-    TTentry *ttentry = ttable.object(node.zobristHash());
-    if (ttentry && ttentry->depth >= depth) {
-        if (ttentry->zobrist_key == node.zobristHash()) {
-            //qDebug() << ttentry->zobrist_key << ttentry->depth << ttentry->value << ttentry->flag;
-            if (ttentry->flag == FLAG_EXACT)
-                return ttentry->value;
-            else if (ttentry->flag == FLAG_LOWER)
-                alpha = qMax<int>(alpha, ttentry->value);
-            else if (ttentry->flag == FLAG_UPPER)
-                beta = qMin<int>(beta, ttentry->value);
-
-            if (alpha >= beta)
-                return ttentry->value;
-        } else {
-            qWarning() << "COLLISION";
-        }
+    // a position seen before on this line or in the game is a draw, going
+    // round the cycle again can't change that
+    if (_history.repeated(1) || _history.noProgress() >= PositionHistory::NO_PROGRESS_LIMIT) {
+        ++_historyDraws;
+        return 0;
     }
 
-    if (depth == 0 || node.winner() != None) {
-        return _heuristic->value(node, color);
+    TranspositionTable::Entry ttentry;
+    const bool found = ttable->probe(node.zobristHash(), ttentry);
+    if (found && ttentry.depth >= depth) {
+        if (ttentry.flag() == TranspositionTable::Exact)
+            return ttentry.value;
+        else if (ttentry.flag() == TranspositionTable::Lower)
+            alpha = qMax<int>(alpha, ttentry.value);
+        else if (ttentry.flag() == TranspositionTable::Upper)
+            beta = qMin<int>(beta, ttentry.value);
+
+        if (alpha >= beta)
+            return ttentry.value;
+    }
+
+    // a side that can't move has lost, this includes having no pieces left
+    if (!node.canMove(Us)) {
+        return -AbstractHeuristic::WIN;
+    }
+    if (node.winner() != None) {
+        return _heuristic->value(node, Us);
+    }
+    if (depth == 0) {
+        return quiescence<Us>(node, alpha, beta);
     }
 
     int bestValue = INT_MIN;
     MoveBit bestMove;
+    const int historyDraws = _historyDraws;
 
-    QList<MoveBit> moves = node.computeValidMoveBits((Color) color);
-    // move ordering?
-    if (ttentry) {
-        moves.prepend(ttentry->bestMove);
+    // move ordering: try the best move of a previous search first, before
+    // generating any other move
+    MovePicker picker(node, Us, found ? ttentry.bestMove : MoveBit(), &_moveCache);
+    MoveBit m;
+    while (picker.next(m)) {
+        HexdameGrid::Undo undo;
+        const bool irreversible = m.isCapture() || node.isPawn(m.from());
+        node.doMove(m, undo);
+        ttable->prefetch(node.zobristHash());
+        _history.push(node.zobristHash(), irreversible);
+        int val = -negamax<Them>(node, depth-1, -beta, -alpha);
+        _history.pop();
+        node.undoMove(undo);
+        if (val > bestValue) {
+            bestValue = val;
+            bestMove = m;
+        }
+        alpha = qMax(alpha, val);
+        if (alpha >= beta) break;
+    }
+    if (_stop) return 0;
+
+    TranspositionTable::Flag flag = TranspositionTable::Exact;
+    if (bestValue <= alphaOrig) {
+        flag = TranspositionTable::Upper;
+    } else if (bestValue >= beta) {
+        flag = TranspositionTable::Lower;
+    }
+    // reached another way, or in another game, the same position may not be
+    // a draw
+    if (_historyDraws == historyDraws)
+        ttable->store(node.zobristHash(), depth, flag, bestValue, bestMove);
+
+    return bestValue;
+}
+
+template<Color Us>
+int
+MTDfPlayer::quiescence(HexdameGrid &node, int alpha, int beta)
+{
+    static const Color Them = Color(-Us);
+
+    nodeCnt++;
+    // captures are forced, only a side without one stands pat
+    if (node.capturingPieces(Us).none()) {
+        if (!node.canMove(Us)) return -AbstractHeuristic::WIN;
+        return _heuristic->value(node, Us);
+    }
+
+    int alphaOrig = alpha;
+
+    // any entry is at least as deep as this
+    TranspositionTable::Entry ttentry;
+    const bool found = ttable->probe(node.zobristHash(), ttentry);
+    if (found) {
+        if (ttentry.flag() == TranspositionTable::Exact)
+            return ttentry.value;
+        else if (ttentry.flag() == TranspositionTable::Lower)
+            alpha = qMax<int>(alpha, ttentry.value);
+        else if (ttentry.flag() == TranspositionTable::Upper)
+            beta = qMin<int>(beta, ttentry.value);
+
+        if (alpha >= beta)
+            return ttentry.value;
     }
-    foreach (MoveBit m, moves) {
-        HexdameGrid child(node);
-        child.makeMoveBit(m);
-        int val = -negamax(child, depth-1, -beta, -alpha, -color);
+
+    int bestValue = INT_MIN;
+    MoveBit bestMove;
+
+    // only captures come out of the picker here, they can't repeat a position
+    MovePicker picker(node, Us, found ? ttentry.bestMove : MoveBit(), &_moveCache);
+    MoveBit m;
+    while (picker.next(m)) {
+        HexdameGrid::Undo undo;
+        node.doMove(m, undo);
+        ttable->prefetch(node.zobristHash());
+        int val = -quiescence<Them>(node, -beta, -alpha);
+        node.undoMove(undo);
         if (val > bestValue) {
             bestValue = val;
             bestMove = m;
@@ -159,19 +474,13 @@ MTDfPlayer::negamax(const HexdameGrid &node, int depth, int alpha, int beta, int
         if (alpha >= beta) break;
     }
 
-    TTentry *new_ttentry = new TTentry();
-    new_ttentry->value = bestValue;
-    new_ttentry->zobrist_key = node.zobristHash();
+    TranspositionTable::Flag flag = TranspositionTable::Exact;
     if (bestValue <= alphaOrig) {
-        new_ttentry->flag = FLAG_UPPER;
+        flag = TranspositionTable::Upper;
     } else if (bestValue >= beta) {
-        new_ttentry->flag = FLAG_LOWER;
-    } else {
-        new_ttentry->flag = FLAG_EXACT;
+        flag = TranspositionTable::Lower;
     }
-    new_ttentry->depth = depth;
-    new_ttentry->bestMove = bestMove;
-    ttable.insert(node.zobristHash(), new_ttentry);
+    ttable->store(node.zobristHash(), 0, flag, bestValue, bestMove);
 
     return bestValue;
 }
@@ -180,6 +489,10 @@ void
 MTDfPlayer::run()
 {
     abort = false;
+    if (_main) {
+        helperSearch();
+        return;
+    }
     qsrand(QDateTime::currentMSecsSinceEpoch());
     play();
 }
@@ -20,14 +20,17 @@
 #ifndef MTDFPLAYER_H
 #define MTDFPLAYER_H
 
-#define FLAG_EXACT 0
-#define FLAG_LOWER 1
-#define FLAG_UPPER 2
-
 #include "player/abstractplayer.h"
-#include <QCache>
+#include "hexdamegrid.h"
+#include "positionhistory.h"
+#include "transpositiontable.h"
+#include "movecache.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
 
-class HexdameGrid;
 class AbstractHeuristic;
 class QTime;
 
@@ -36,11 +39,31 @@ class MTDfPlayer : public AbstractPlayer
     Q_OBJECT
 
 public:
-    MTDfPlayer(HexdameGame *game, Color color, AbstractHeuristic *heuristic);
+    static const int MAX_DEPTH = 25;
+
+    // ttable is shared with other players and has to outlive them
+    MTDfPlayer(HexdameGame *game, Color color, AbstractHeuristic *heuristic, TranspositionTable *ttable);
     virtual ~MTDfPlayer();
 
     virtual void play();
 
+    // threads searching each move, all but one are helpers of the main
+    // search, set by the search/threads preference
+    void setThreads(int threads) { _threads = qMax(1, threads); }
+    int threads() const { return _threads; }
+    // null-window probes of a node run at once on a pool of threads, set by
+    // the search/probes preference
+    void setProbes(int probes);
+    int probes() const { return _probes; }
+
+    // the best moves of root after searching it for msecs or to depth plies,
+    // whichever comes first
+    QList<MoveBit> search(const HexdameGrid &root, const PositionHistory &history,
+                          int depth = MAX_DEPTH, int msecs = 6000);
+    // depth reached and nodes visited by all threads in the last search
+    int depth() const { return _depth; }
+    int nodes() const { return nodeCnt; }
+
 protected:
     void run();
 
@@ -48,24 +71,54 @@ private slots:
     void timesUp() { abort = true; }
 
 private:
-    QList<MoveBit> iterativeDeepening(const HexdameGrid& root, QTime tic);
-    int mtdf(const HexdameGrid& node, int f, int depth);
-    int negamax(const HexdameGrid& node, int depth, int alpha, int beta, int color);
-
-    struct TTentry {
-        quint64 zobrist_key;
-        quint8 depth;
-        quint8 flag;
-        qint16 value;
-        MoveBit bestMove;
-    };
-    QCache<quint64, TTentry> ttable;
+    class Probe;
+
+    // a helper thread of main, searching the same root
+    MTDfPlayer(MTDfPlayer *main, int id);
+
+    QList<MoveBit> iterativeDeepening(int maxDepth, QTime tic, int msecs);
+    void helperSearch();
+    // value of m for us, searched depth plies deep
+    int searchMove(const MoveBit &m, int guess, int depth);
+    int mtdf(HexdameGrid& node, int f, int depth);
+    // mtdf with _probes test values searched at once
+    int parallelMtdf(HexdameGrid& node, int f, int depth);
+    // null-window search of node at the test value beta, seen from White's side
+    int probe(HexdameGrid& node, int depth, int beta);
+    // Us is the side to move, the two sides call each other
+    template<Color Us> int negamax(HexdameGrid& node, int depth, int alpha, int beta);
+    // the captures left at the horizon, kept in the table at depth 0
+    template<Color Us> int quiescence(HexdameGrid& node, int alpha, int beta);
+
+    TranspositionTable *ttable;
+    MoveCache _moveCache; // megabytes set by the search/movecache preference, off by default
 
     quint8 _depth = 0;
     QTime *startTime;
 
+    HexdameGrid _root;
+    // the game so far followed by the line being searched
+    PositionHistory _history;
     AbstractHeuristic *_heuristic;
     int nodeCnt;
+    // draws by repetition or lack of progress found so far, a result they
+    // went into depends on the way to the position and isn't stored
+    int _historyDraws = 0;
+
+    int _threads;
+    MTDfPlayer *_main = 0;
+    int _id = 0;
+    // set by the main search when a helper has to return
+    QAtomicInt _stop;
+    // depth of the iteration the main search is on, followed by the helpers
+    QAtomicInt _iteration;
+
+    int _probes;
+    // search state of each probe that can run at once, only main has them
+    QList<MTDfPlayer *> _probers;
+    QThreadPool *_probePool = 0;
+    QMutex _probeMutex;
+    QWaitCondition _probeFinished;
 };
 
 #endif // MTDFPLAYER_H
@@ -57,57 +57,110 @@ NegaMaxPlayer::play()
 
     nodeCnt = 0;
     int bestValue = INT_MIN;
-    QList<Move> bestMoves;
-    QHash<Coord, QMultiHash<Coord, Move>> moves = _game->grid().computeValidMoves(_color);
+    QList<MoveBit> bestMoves;
+    HexdameGrid root(_game->grid());
+    _history = _game->history();
+    MoveList moves;
+    root.computeValidMoveBits(_color, moves);
     int depth = 4;
-    foreach (auto m, moves.values()) {
-        foreach (Move mm, m.values()) {
-            if (abort) return;
-
-            nodeCnt++;
-            HexdameGrid child(_game->grid());
-            child.makeMove(mm);
-            int val = -negamax(child, depth-1, -INT_MAX, INT_MAX, -_color);
-
-            if (bestValue <= val) {
-                if (bestValue < val) {
-                    bestValue = val;
-                    bestMoves.clear();
-                }
-                bestMoves << mm;
+    for (int i = 0; i < moves.size(); ++i) {
+        if (abort) return;
+
+        const MoveBit &m = moves.at(i);
+        nodeCnt++;
+        HexdameGrid::Undo undo;
+        const bool irreversible = m.isCapture() || root.isPawn(m.from());
+        root.doMove(m, undo);
+        _history.push(root.zobristHash(), irreversible);
+        int val = _color == White ? -negamax<Black>(root, depth-1, -INT_MAX, INT_MAX)
+                                  : -negamax<White>(root, depth-1, -INT_MAX, INT_MAX);
+        _history.pop();
+        root.undoMove(undo);
+
+        if (bestValue <= val) {
+            if (bestValue < val) {
+                bestValue = val;
+                bestMoves.clear();
             }
+            bestMoves << m;
         }
     }
     //qDebug("%7s %5s %2d %8d %10d", "NMP", _color == White ? "white" : "black", depth, nodeCnt, tic.elapsed());
     qDebug() << cnt/total+1;
 
-    emit move(bestMoves.at(qrand() % bestMoves.size()));
+    emit moveBit(bestMoves.at(qrand() % bestMoves.size()));
 }
 
+template<Color Us>
 int
-NegaMaxPlayer::negamax(const HexdameGrid &node, int depth, int alpha, int beta, int color)
+NegaMaxPlayer::negamax(HexdameGrid &node, int depth, int alpha, int beta)
 {
+    static const Color Them = Color(-Us);
+
     if (abort) return 0x42;
 
     nodeCnt++;
-    if (depth == 0 || node.winner() != None) {
-        return _heuristic->value(node, color);
+    // repetitions and games going nowhere are draws
+    if (_history.repeated(1) || _history.noProgress() >= PositionHistory::NO_PROGRESS_LIMIT)
+        return 0;
+
+    // so is having no move left a loss
+    if (!node.canMove(Us)) {
+        return -AbstractHeuristic::WIN;
+    }
+    if (node.winner() != None) {
+        return _heuristic->value(node, Us);
+    }
+    if (depth == 0) {
+        return quiescence<Us>(node, alpha, beta);
     }
     int bestValue = INT_MIN;
 
-    QHash<Coord, QMultiHash<Coord, Move>> moves = node.computeValidMoves((Color) color);
-    QMultiHash<Coord, Move> m;
+    MoveList moves;
+    node.computeValidMoveBits(Us, moves);
     ++total;
-    foreach (m, moves.values()) {
-        foreach (Move mm, m.values()) {
-            ++cnt;
-            HexdameGrid child(node);
-            child.makeMove(mm);
-            int val = -negamax(child, depth-1, -beta, -alpha, -color);
-            bestValue = qMax(bestValue, val);
-            alpha = qMax(alpha, val);
-            if (alpha >= beta) break;
-        }
+    for (int i = 0; i < moves.size(); ++i) {
+        ++cnt;
+        const MoveBit &m = moves.at(i);
+        HexdameGrid::Undo undo;
+        const bool irreversible = m.isCapture() || node.isPawn(m.from());
+        node.doMove(m, undo);
+        _history.push(node.zobristHash(), irreversible);
+        int val = -negamax<Them>(node, depth-1, -beta, -alpha);
+        _history.pop();
+        node.undoMove(undo);
+        bestValue = qMax(bestValue, val);
+        alpha = qMax(alpha, val);
+        if (alpha >= beta) break;
+    }
+    return bestValue;
+}
+
+template<Color Us>
+int
+NegaMaxPlayer::quiescence(HexdameGrid &node, int alpha, int beta)
+{
+    static const Color Them = Color(-Us);
+
+    nodeCnt++;
+    // captures are forced, only a side without one stands pat
+    if (node.capturingPieces(Us).none()) {
+        if (!node.canMove(Us)) return -AbstractHeuristic::WIN;
+        return _heuristic->value(node, Us);
+    }
+
+    int bestValue = INT_MIN;
+
+    // every move is a capture, they can't repeat a position
+    MoveList moves;
+    node.computeValidMoveBits(Us, moves);
+    for (int i = 0; i < moves.size(); ++i) {
+        HexdameGrid::Undo undo;
+        node.doMove(moves.at(i), undo);
+        int val = -quiescence<Them>(node, -beta, -alpha);
+        node.undoMove(undo);
+        bestValue = qMax(bestValue, val);
+        alpha = qMax(alpha, val);
         if (alpha >= beta) break;
     }
     return bestValue;
@@ -21,8 +21,9 @@
 #define NEGAMAX_H
 
 #include "player/abstractplayer.h"
+#include "hexdamegrid.h"
+#include "positionhistory.h"
 
-class HexdameGrid;
 class AbstractHeuristic;
 
 class NegaMaxPlayer : public AbstractPlayer
@@ -39,11 +40,15 @@ protected:
     void run();
 
 private:
-    int negamax(const HexdameGrid& node, int depth, int alpha, int beta, int color);
+    template<Color Us> int negamax(HexdameGrid& node, int depth, int alpha, int beta);
+    // searches the captures left at the horizon until the position is quiet
+    template<Color Us> int quiescence(HexdameGrid& node, int alpha, int beta);
     int nodeCnt = 0;
     static int cnt;
     static int total;
 
+    // the game so far followed by the line being searched
+    PositionHistory _history;
     AbstractHeuristic *_heuristic;
 };
 
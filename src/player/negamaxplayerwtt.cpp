@@ -28,13 +28,11 @@
 
 #include <QtDebug>
 
-NegaMaxPlayerWTt::NegaMaxPlayerWTt(HexdameGame *game, Color color, AbstractHeuristic *heuristic)
+NegaMaxPlayerWTt::NegaMaxPlayerWTt(HexdameGame *game, Color color, AbstractHeuristic *heuristic, TranspositionTable *ttable)
     : AbstractPlayer(AI, game, color)
+    , ttable(ttable)
     , _heuristic(heuristic)
 {
-    //FIXME this does not prealocate the underlying hashtable :@
-    // do I really need to subclass QCache?
-    ttable.setMaxCost(500000000);
 }
 
 NegaMaxPlayerWTt::~NegaMaxPlayerWTt()
@@ -54,17 +52,27 @@ NegaMaxPlayerWTt::play()
     QTime tic;
     tic.start();
     nodeCnt = 0;
+    ttable->newSearch();
     int bestValue = INT_MIN;
     QList<MoveBit> bestMoves;
-    QList<MoveBit> moves = _game->grid().computeValidMoveBits(_color);
+    HexdameGrid root(_game->grid());
+    _history = _game->history();
+    MoveList moves;
+    root.computeValidMoveBits(_color, moves);
     int depth = 4;
-    foreach (MoveBit m, moves) {
+    for (int i = 0; i < moves.size(); ++i) {
         if (abort) return;
 
+        const MoveBit &m = moves.at(i);
         nodeCnt++;
-        HexdameGrid child(_game->grid());
-        child.makeMoveBit(m);
-        int val = -negamax(child, depth - 1, -INT_MAX, INT_MAX, -_color);
+        HexdameGrid::Undo undo;
+        const bool irreversible = m.isCapture() || root.isPawn(m.from());
+        root.doMove(m, undo);
+        _history.push(root.zobristHash(), irreversible);
+        int val = _color == White ? -negamax<Black>(root, depth - 1, -INT_MAX, INT_MAX)
+                                  : -negamax<White>(root, depth - 1, -INT_MAX, INT_MAX);
+        _history.pop();
+        root.undoMove(undo);
 
         if (bestValue <= val) {
             if (bestValue < val) {
@@ -75,66 +83,140 @@ NegaMaxPlayerWTt::play()
         }
     }
     qDebug("%10s %5s %2d %8d %10d", "NMPwTt", _color == White ? "white" : "black", depth, nodeCnt, tic.elapsed());
-    qDebug() << ttable.totalCost() << ttable.maxCost();
 
     qDebug() << bestMoves.size();
     emit moveBit(bestMoves.at(qrand() % bestMoves.size()));
 }
 
+template<Color Us>
 int
-NegaMaxPlayerWTt::negamax(const HexdameGrid &node, int depth, int alpha, int beta, int color)
+NegaMaxPlayerWTt::negamax(HexdameGrid &node, int depth, int alpha, int beta)
 {
+    static const Color Them = Color(-Us);
+
     // return an actuall score +-INF or alpha/beta bounds
     if (abort) return 0x42;
 
     nodeCnt++;
+    // repetitions and games going nowhere are draws
+    if (_history.repeated(1) || _history.noProgress() >= PositionHistory::NO_PROGRESS_LIMIT) {
+        ++_historyDraws;
+        return 0;
+    }
+
     int alphaOrig = alpha;
 
-    TTentry *ttentry = ttable.object(node.zobristHash());
-    if (ttentry && ttentry->depth >= depth) {
-        if (ttentry->zobrist_key == node.zobristHash()) {
-            //qDebug() << ttentry->zobrist_key << ttentry->depth << ttentry->value << ttentry->flag;
-            if (ttentry->flag == FLAG_EXACT)
-                return ttentry->value;
-            else if (ttentry->flag == FLAG_LOWER)
-                alpha = qMax<int>(alpha, ttentry->value);
-            else if (ttentry->flag == FLAG_UPPER)
-                beta = qMin<int>(beta, ttentry->value);
-
-            if (alpha >= beta)
-                return ttentry->value;
-        } else {
-            qDebug() << "COLLISION";
-        }
+    TranspositionTable::Entry ttentry;
+    const bool found = ttable->probe(node.zobristHash(), ttentry);
+    if (found && ttentry.depth >= depth) {
+        if (ttentry.flag() == TranspositionTable::Exact)
+            return ttentry.value;
+        else if (ttentry.flag() == TranspositionTable::Lower)
+            alpha = qMax<int>(alpha, ttentry.value);
+        else if (ttentry.flag() == TranspositionTable::Upper)
+            beta = qMin<int>(beta, ttentry.value);
+
+        if (alpha >= beta)
+            return ttentry.value;
     }
-    if (depth == 0 || node.winner() != None) {
-        return _heuristic->value(node, color);
+    // so is having no move left a loss
+    if (!node.canMove(Us)) {
+        return -AbstractHeuristic::WIN;
+    }
+    if (node.winner() != None) {
+        return _heuristic->value(node, Us);
+    }
+    if (depth == 0) {
+        return quiescence<Us>(node, alpha, beta);
+    }
+
+    int bestValue = INT_MIN;
+    const int historyDraws = _historyDraws;
+
+    MoveList moves;
+    node.computeValidMoveBits(Us, moves);
+    for (int i = 0; i < moves.size(); ++i) {
+        const MoveBit &m = moves.at(i);
+        HexdameGrid::Undo undo;
+        const bool irreversible = m.isCapture() || node.isPawn(m.from());
+        node.doMove(m, undo);
+        ttable->prefetch(node.zobristHash());
+        _history.push(node.zobristHash(), irreversible);
+        int val = -negamax<Them>(node, depth-1, -beta, -alpha);
+        _history.pop();
+        node.undoMove(undo);
+        // a cut off search has no value, it mustn't reach the table
+        if (abort) return 0x42;
+        bestValue = qMax(bestValue, val);
+        alpha = qMax(alpha, val);
+        if (alpha >= beta) break;
+    }
+
+    TranspositionTable::Flag flag = TranspositionTable::Exact;
+    if (bestValue <= alphaOrig) {
+        flag = TranspositionTable::Upper;
+    } else if (bestValue >= beta) {
+        flag = TranspositionTable::Lower;
+    }
+    // reached another way, or in another game, the same position may not be
+    // a draw
+    if (_historyDraws == historyDraws)
+        ttable->store(node.zobristHash(), depth, flag, bestValue, MoveBit());
+
+    return bestValue;
+}
+
+template<Color Us>
+int
+NegaMaxPlayerWTt::quiescence(HexdameGrid &node, int alpha, int beta)
+{
+    static const Color Them = Color(-Us);
+
+    nodeCnt++;
+    // captures are forced, only a side without one stands pat
+    if (node.capturingPieces(Us).none()) {
+        if (!node.canMove(Us)) return -AbstractHeuristic::WIN;
+        return _heuristic->value(node, Us);
+    }
+
+    int alphaOrig = alpha;
+
+    // any entry is at least as deep as this
+    TranspositionTable::Entry ttentry;
+    if (ttable->probe(node.zobristHash(), ttentry)) {
+        if (ttentry.flag() == TranspositionTable::Exact)
+            return ttentry.value;
+        else if (ttentry.flag() == TranspositionTable::Lower)
+            alpha = qMax<int>(alpha, ttentry.value);
+        else if (ttentry.flag() == TranspositionTable::Upper)
+            beta = qMin<int>(beta, ttentry.value);
+
+        if (alpha >= beta)
+            return ttentry.value;
     }
 
     int bestValue = INT_MIN;
 
-    QList<MoveBit> moves = node.computeValidMoveBits((Color) color);
-    foreach (MoveBit m, moves) {
-        HexdameGrid child(node);
-        child.makeMoveBit(m);
-        int val = -negamax(child, depth-1, -beta, -alpha, -color);
+    MoveList moves;
+    node.computeValidMoveBits(Us, moves);
+    for (int i = 0; i < moves.size(); ++i) {
+        HexdameGrid::Undo undo;
+        node.doMove(moves.at(i), undo);
+        ttable->prefetch(node.zobristHash());
+        int val = -quiescence<Them>(node, -beta, -alpha);
+        node.undoMove(undo);
         bestValue = qMax(bestValue, val);
         alpha = qMax(alpha, val);
         if (alpha >= beta) break;
     }
 
-    TTentry *new_ttentry = new TTentry();
-    new_ttentry->value = bestValue;
-    new_ttentry->zobrist_key = node.zobristHash();
+    TranspositionTable::Flag flag = TranspositionTable::Exact;
     if (bestValue <= alphaOrig) {
-        new_ttentry->flag = FLAG_UPPER;
+        flag = TranspositionTable::Upper;
     } else if (bestValue >= beta) {
-        new_ttentry->flag = FLAG_LOWER;
-    } else {
-        new_ttentry->flag = FLAG_EXACT;
+        flag = TranspositionTable::Lower;
     }
-    new_ttentry->depth = depth;
-    ttable.insert(node.zobristHash(), new_ttentry);
+    ttable->store(node.zobristHash(), 0, flag, bestValue, MoveBit());
 
     return bestValue;
 }
@@ -20,14 +20,11 @@
 #ifndef NEGAMAXPLAYERWTT_H
 #define NEGAMAXPLAYERWTT_H
 
-#define FLAG_EXACT 0
-#define FLAG_LOWER 1
-#define FLAG_UPPER 2
-
 #include "player/abstractplayer.h"
-#include <QCache>
+#include "hexdamegrid.h"
+#include "positionhistory.h"
+#include "transpositiontable.h"
 
-class HexdameGrid;
 class AbstractHeuristic;
 
 class NegaMaxPlayerWTt : public AbstractPlayer
@@ -35,7 +32,8 @@ class NegaMaxPlayerWTt : public AbstractPlayer
     Q_OBJECT
 
 public:
-    NegaMaxPlayerWTt(HexdameGame *game, Color color, AbstractHeuristic *heuristic);
+    // ttable has to outlive the player
+    NegaMaxPlayerWTt(HexdameGame *game, Color color, AbstractHeuristic *heuristic, TranspositionTable *ttable);
     virtual ~NegaMaxPlayerWTt();
 
     virtual void play();
@@ -44,18 +42,19 @@ protected:
     void run();
 
 private:
-    int negamax(const HexdameGrid& node, int depth, int alpha, int beta, int color);
+    template<Color Us> int negamax(HexdameGrid& node, int depth, int alpha, int beta);
+    // the captures left at the horizon, kept in the table at depth 0
+    template<Color Us> int quiescence(HexdameGrid& node, int alpha, int beta);
 
-    struct TTentry {
-        quint64 zobrist_key;
-        quint8 depth;
-        quint8 flag;
-        qint16 value;
-    };
-    QCache<quint64, TTentry> ttable;
+    TranspositionTable *ttable;
 
+    // the game so far followed by the line being searched
+    PositionHistory _history;
     AbstractHeuristic *_heuristic;
     int nodeCnt;
+    // draws by repetition or lack of progress found so far, a result they
+    // went into depends on the way to the position and isn't stored
+    int _historyDraws = 0;
 };
 
 #endif // NEGAMAXPLAYERWTT_H
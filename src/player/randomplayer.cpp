@@ -42,7 +42,8 @@ RandomPlayer::~RandomPlayer()
 void
 RandomPlayer::play()
 {
-    QList<MoveBit> moves = _game->grid().computeValidMoveBits(_color);
+    MoveList moves;
+    _game->grid().computeValidMoveBits(_color, moves);
 
     int rand = qrand() % moves.size();
     MoveBit randMove = moves.at(rand);
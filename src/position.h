@@ -0,0 +1,52 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "bitboard.h"
+
+#include <type_traits>
+
+/**
+ * The bare state of a game: where the pieces are and its Zobrist hash.
+ *
+ * Plain data only, so it can be memcpy'd into arrays, transposition table
+ * entries, files or across threads.
+ */
+template<class BB>
+struct BasicPosition {
+    typedef BB BitBoard;
+
+    BitBoard white;
+    BitBoard black;
+    BitBoard kings;
+    quint64 hash;
+
+    bool operator==(const BasicPosition &other) const {
+        return white == other.white && black == other.black && kings == other.kings;
+    }
+    bool operator!=(const BasicPosition &other) const { return !(*this == other); }
+};
+
+typedef BasicPosition<BitBoard> Position;
+static_assert(sizeof(Position) == 32, "Position should fit in half a cache line");
+static_assert(std::is_trivially_copyable<Position>::value, "Position should be memcpy-able");
+
+#endif // POSITION_H
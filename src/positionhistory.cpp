@@ -0,0 +1,44 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "positionhistory.h"
+
+const int PositionHistory::NO_PROGRESS_LIMIT;
+
+void
+PositionHistory::reset(quint64 hash)
+{
+    _entries.clear();
+    // a search pushes a few dozen plies on top of a game
+    _entries.reserve(NO_PROGRESS_LIMIT + 64);
+    Entry e = { hash, 0 };
+    _entries.append(e);
+}
+
+bool
+PositionHistory::repeated(int times) const
+{
+    const Entry &now = _entries.last();
+    const int first = _entries.size() - 1 - now.noProgress;
+    // the hash includes the side to move, which only matches every other ply
+    for (int i = _entries.size() - 3; i >= first; i -= 2) {
+        if (_entries.at(i).hash == now.hash && --times == 0)
+            return true;
+    }
+    return times <= 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef POSITIONHISTORY_H
+#define POSITIONHISTORY_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * The Zobrist hashes of the positions of a game, one per ply, to tell
+ * repetitions and games that stopped making progress.
+ *
+ * A capture or a pawn move can never be taken back, so only positions since
+ * the last one of those can repeat and only those are scanned. The game keeps
+ * one for its moves, a search copies it and pushes and pops the line it is
+ * looking at on top.
+ */
+class PositionHistory
+{
+public:
+    // plies without a capture or a pawn move after which the game is a draw
+    static const int NO_PROGRESS_LIMIT = 50;
+
+    explicit PositionHistory(quint64 hash = 0) { reset(hash); }
+
+    // starts over from the position with hash
+    void reset(quint64 hash);
+
+    // the position reached by a move, irreversible for captures and pawn moves
+    void push(quint64 hash, bool irreversible)
+    {
+        Entry e = { hash, irreversible ? 0 : _entries.last().noProgress + 1 };
+        _entries.append(e);
+    }
+    void pop() { Q_ASSERT(_entries.size() > 1); _entries.removeLast(); }
+
+    int size() const { return _entries.size(); }
+    // plies since the last capture or pawn move
+    int noProgress() const { return _entries.last().noProgress; }
+    // whether the current position was there at least times before
+    bool repeated(int times) const;
+
+    // threefold repetition, or nothing happened for too long
+    bool isDraw() const { return noProgress() >= NO_PROGRESS_LIMIT || repeated(2); }
+
+private:
+    struct Entry {
+        quint64 hash;
+        int noProgress;
+    };
+    QVector<Entry> _entries;
+};
+
+#endif // POSITIONHISTORY_H
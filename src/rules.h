@@ -0,0 +1,53 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef RULES_H
+#define RULES_H
+
+/**
+ * The rules the move generator follows.
+ *
+ * Each variant is a set of compile time constants handed to the grid as a
+ * template parameter, so the checks fold away and the standard rules pay
+ * nothing for the others. Pawns always become kings at the end of a move,
+ * not when a capture merely passes over the far side.
+ */
+struct StandardRules {
+    // only the captures taking the most pieces may be played, otherwise
+    // any capture is fine as long as it isn't stopped halfway
+    static const bool MAXIMUM_CAPTURE = true;
+    // pawns capture in all six directions, otherwise only forwards
+    static const bool PAWNS_CAPTURE_BACKWARDS = true;
+    // kings move and capture along whole lines, otherwise one cell at a
+    // time like pawns, in all six directions
+    static const bool FLYING_KINGS = true;
+};
+
+struct FreeCaptureRules : StandardRules {
+    static const bool MAXIMUM_CAPTURE = false;
+};
+
+struct ShortKingRules : StandardRules {
+    static const bool FLYING_KINGS = false;
+};
+
+struct ForwardCaptureRules : StandardRules {
+    static const bool PAWNS_CAPTURE_BACKWARDS = false;
+};
+
+#endif // RULES_H
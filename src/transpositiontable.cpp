@@ -0,0 +1,269 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "transpositiontable.h"
+
+#include "gridtables.h"
+
+#include <QFile>
+#include <QtDebug>
+
+#include <cstring>
+
+#include <sys/file.h>
+
+static_assert(GridTables::CELLS <= 61, "the taken pieces of a move should fit in 61 bits");
+
+const quint32 TranspositionTable::VERSION;
+
+quint32
+TranspositionTable::check(const Slot &s)
+{
+    // multiplied so that a slot torn between two entries changes the high bits
+    const quint64 x = (s.taken & TAKEN_MASK) * Q_UINT64_C(0x9e3779b97f4a7c15) ^ (s.data & DATA_MASK);
+    return quint32(x ^ x >> KEY_BITS ^ x >> 2 * KEY_BITS) & ((1 << KEY_BITS) - 1);
+}
+
+TranspositionTable::Entry
+TranspositionTable::unpack(const Slot &s)
+{
+    Entry e;
+    e.value = qint16(s.data >> 28);
+    e.depth = quint8(s.data >> 20);
+    e.state = quint8(s.data >> 12);
+    e.bestMove = MoveBit(s.data & 0x3f, s.data >> 6 & 0x3f, BitBoard(s.taken & TAKEN_MASK));
+    return e;
+}
+
+TranspositionTable::Slot
+TranspositionTable::pack(const Entry &e, quint32 key)
+{
+    Slot s;
+    s.taken = e.bestMove.taken().word();
+    s.data = e.bestMove.from() | e.bestMove.to() << 6 | quint32(e.state) << 12 | quint32(e.depth) << 20
+           | quint64(quint16(e.value)) << 28;
+    key ^= check(s);
+    s.taken |= quint64(key & 7) << TAKEN_BITS;
+    s.data |= quint64(key >> 3) << DATA_BITS;
+    return s;
+}
+
+// identifies the Zobrist keys of the standard grid, the hashes of a table
+// file only mean something with the same ones
+static quint64
+zobristFingerprint()
+{
+    static const GridTables tables = GridTables::make();
+    quint64 fingerprint = tables.zobristTurn;
+    for (int idx = 0; idx < GridTables::CELLS; ++idx) {
+        for (int j = 0; j < 4; ++j) {
+            fingerprint = (fingerprint ^ tables.zobrist[idx][j]) * Q_UINT64_C(0x100000001b3);
+        }
+    }
+    return fingerprint;
+}
+
+TranspositionTable::TranspositionTable(int megabytes, const QString &fileName)
+    : _buckets(0)
+    , _generation(0)
+    , _file(0)
+    , _header(0)
+{
+    static_assert(sizeof(Bucket) == 64, "a bucket should fill a cache line");
+    static_assert(sizeof(FileHeader) == sizeof(Bucket), "the buckets of a file should stay aligned");
+
+    quint64 buckets = 1;
+    while (buckets * 2 * sizeof(Bucket) <= (quint64(qMax(megabytes, 1)) << 20)) buckets *= 2;
+    _mask = buckets - 1;
+
+    if (!fileName.isEmpty() && map(fileName))
+        return;
+
+    _buckets = static_cast<Bucket *>(qMallocAligned(buckets * sizeof(Bucket), sizeof(Bucket)));
+    Q_CHECK_PTR(_buckets);
+    clear();
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    if (_file) {
+        // the entries stay in the file
+        _file->unmap(reinterpret_cast<uchar *>(_header));
+        delete _file;
+    } else {
+        qFreeAligned(_buckets);
+    }
+}
+
+bool
+TranspositionTable::map(const QString &fileName)
+{
+    const qint64 size = sizeof(FileHeader) + (_mask + 1) * sizeof(Bucket);
+
+    _file = new QFile(fileName);
+    uchar *data = 0;
+    QString error;
+    if (!_file->open(QIODevice::ReadWrite)) {
+        error = _file->errorString();
+    } else {
+        // every process mapping the file holds a shared lock on it, the
+        // entries are checked by their key so they can all write them. Only
+        // setting the file up takes it exclusively, which it can't while
+        // another process maps it. Closing the file releases the lock.
+        flock(_file->handle(), LOCK_SH);
+        data = mapValid(size);
+        if (!data && flock(_file->handle(), LOCK_EX | LOCK_NB) == 0) {
+            // entries made with other keys or laid out differently are of
+            // no use
+            if (_file->resize(size))
+                data = _file->map(0, size);
+            if (data) {
+                _header = reinterpret_cast<FileHeader *>(data);
+                _buckets = reinterpret_cast<Bucket *>(data + sizeof(FileHeader));
+                clear();
+                std::memset(static_cast<void *>(_header), 0, sizeof(FileHeader));
+                std::memcpy(_header->magic, "hexdame", sizeof(_header->magic));
+                _header->version = VERSION;
+                _header->buckets = _mask + 1;
+                _header->zobrist = zobristFingerprint();
+            } else {
+                error = _file->errorString();
+            }
+            flock(_file->handle(), LOCK_SH);
+        } else if (!data) {
+            // another process may have set it up in the meantime
+            flock(_file->handle(), LOCK_SH);
+            data = mapValid(size);
+            if (!data) error = "it is used with another size or version by another process";
+        }
+    }
+    if (!data) {
+        qWarning() << "Can't map the transposition table from" << fileName << ":" << error;
+        delete _file;
+        _file = 0;
+        _header = 0;
+        return false;
+    }
+    _header = reinterpret_cast<FileHeader *>(data);
+    _buckets = reinterpret_cast<Bucket *>(data + sizeof(FileHeader));
+
+    // the entries of the last run are older than anything we'll store
+    _generation = _header->generation;
+    newSearch();
+    return true;
+}
+
+uchar *
+TranspositionTable::mapValid(qint64 size)
+{
+    if (_file->size() != size) return 0;
+    uchar *data = _file->map(0, size);
+    if (!data) return 0;
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+    if (std::memcmp(header->magic, "hexdame", sizeof(header->magic)) == 0
+            && header->version == VERSION
+            && header->buckets == _mask + 1
+            && header->zobrist == zobristFingerprint())
+        return data;
+
+    _file->unmap(data);
+    return 0;
+}
+
+bool
+TranspositionTable::probe(quint64 hash, Entry &entry) const
+{
+    const Bucket &bucket = _buckets[hash & _mask];
+    const quint32 k = key(hash);
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        // copy first, another thread may be writing the entry
+        const Slot s = bucket.entries[i];
+        if (matches(s, k)) {
+            entry = unpack(s);
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+TranspositionTable::store(quint64 hash, int depth, Flag flag, int value, const MoveBit &bestMove)
+{
+    Bucket &bucket = _buckets[hash & _mask];
+    const quint32 k = key(hash);
+
+    Entry entries[BUCKET_SIZE];
+    bool same[BUCKET_SIZE];
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        const Slot s = bucket.entries[i];
+        entries[i] = unpack(s);
+        same[i] = matches(s, k);
+    }
+
+    // the entry of the same position, else the least useful of the slots
+    // keeping the deepest results, else the last slot
+    int replace = -1;
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        if (same[i]) {
+            replace = i;
+            break;
+        }
+    }
+    // a bound of a shallower search, such as the quiescence one at depth 0,
+    // tells less than a deeper one of this search
+    if (replace >= 0 && flag != Exact) {
+        const Entry &e = entries[replace];
+        if (e.depth > depth && age(e) == 0) return;
+    }
+    if (replace < 0) {
+        replace = BUCKET_SIZE - 1;
+        for (int i = 0; i < BUCKET_SIZE - 1; ++i) {
+            const Entry &e = entries[i];
+            if (!(e.state & USED) || age(e) > 0 || e.depth <= depth) {
+                const Entry &r = entries[replace];
+                if (replace == BUCKET_SIZE - 1 || e.depth - 8 * age(e) < r.depth - 8 * age(r)) {
+                    replace = i;
+                }
+            }
+        }
+    }
+
+    Entry entry = entries[replace];
+    // keep the move we knew if there is no new one
+    if (!bestMove.empty() || !same[replace])
+        entry.bestMove = bestMove;
+    entry.value = value;
+    entry.depth = depth;
+    entry.state = flag | USED | _generation << GENERATION_SHIFT;
+    bucket.entries[replace] = pack(entry, k);
+}
+
+void
+TranspositionTable::newSearch()
+{
+    _generation = (_generation + 1) & GENERATION_MASK;
+    if (_header)
+        _header->generation = _generation;
+}
+
+void
+TranspositionTable::clear()
+{
+    std::memset(static_cast<void *>(_buckets), 0, (_mask + 1) * sizeof(Bucket));
+}
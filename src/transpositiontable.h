@@ -0,0 +1,152 @@
+/*
+ * hexdame: a draughts game played on a hexagonal grid.
+ * Copyright (C) 2013  Samir Benmendil <samir.benmendil@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include "commondefs.h"
+
+#include <QString>
+
+class QFile;
+
+/**
+ * Search results of positions keyed by their Zobrist hash, in a table of
+ * fixed size allocated up front.
+ *
+ * Entries come in buckets of four filling a cache line, a probe costs at most
+ * one cache miss. The first three slots of a bucket keep the deepest results,
+ * unless they are from an earlier search, the last one takes whatever doesn't
+ * make it there. A position keeps its deeper result of the current search
+ * over a shallower bound. An entry is packed into 16 bytes keeping 23 bits of the hash,
+ * the bits picking the bucket are implied. A probe of a position that isn't
+ * in the table returns the entry of another one about once in two million
+ * times. The values are used as they are, the best moves are checked against
+ * the position by MovePicker before being played.
+ *
+ * Threads share a table without locking: the key is stored xored with the
+ * rest of the entry, as in Hyatt's lockless hashing, so an entry torn by two
+ * threads writing it at once almost never verifies and is taken as missing.
+ *
+ * Given a file, the table is mapped into memory from it instead, so its
+ * entries outlive the process and warm up the next one, and processes mapping
+ * the same file share them. A file written with other Zobrist keys or another
+ * layout is set up again, unless another process is using it, then this one
+ * goes without it. Results
+ * depending on the way to a position, such as a draw by repetition, are kept
+ * out of the table by the players.
+ */
+class TranspositionTable
+{
+public:
+    // bound of a stored value
+    enum Flag {
+        Exact = 0,
+        Lower,
+        Upper
+    };
+
+    struct Entry {
+        qint16 value;
+        quint8 depth;
+        quint8 state;  // flag, used bit and generation
+        MoveBit bestMove;
+
+        Flag flag() const { return Flag(state & 3); }
+    };
+
+    // size in megabytes, rounded down to a power of two buckets, kept in
+    // fileName if there is one
+    explicit TranspositionTable(int megabytes, const QString &fileName = QString());
+    ~TranspositionTable();
+
+    // copies the entry of hash into entry, false if there is none
+    bool probe(quint64 hash, Entry &entry) const;
+    void store(quint64 hash, int depth, Flag flag, int value, const MoveBit &bestMove);
+    // starts loading the bucket of hash, to be called as soon as it is known
+    void prefetch(quint64 hash) const { __builtin_prefetch(&_buckets[hash & _mask]); }
+
+    // entries of earlier searches make room for new ones first
+    void newSearch();
+    void clear();
+
+    int megabytes() const { return int((_mask + 1) * sizeof(Bucket) >> 20); }
+    // whether the table is mapped from a file
+    bool persistent() const { return _file; }
+
+private:
+    static const int BUCKET_SIZE = 4;
+    static const int USED = 4;
+    static const int GENERATION_SHIFT = 3;
+    static const int GENERATION_MASK = 0x1f;
+
+    // an entry as stored, the key is split between the spare bits of both
+    // words and xored with the rest, see check()
+    struct Slot {
+        quint64 taken;  // taken pieces of the best move, 3 bits of the key
+        quint64 data;   // from, to, state, depth, value, 20 bits of the key
+    };
+
+    struct Bucket {
+        Slot entries[BUCKET_SIZE];
+    };
+
+    // start of a table file, the buckets follow it
+    struct FileHeader {
+        char magic[8];
+        quint32 version;
+        quint32 generation;
+        quint64 buckets;
+        quint64 zobrist;  // fingerprint of the keys the hashes are made of
+        char reserved[32];
+    };
+    static const quint32 VERSION = 3;
+
+    // maps the table from fileName, false if it can't
+    bool map(const QString &fileName);
+    // the file mapped if it already holds a table like this one, else 0
+    uchar *mapValid(qint64 size);
+
+    static const int KEY_BITS = 23;
+    static const int TAKEN_BITS = 61;
+    static const int DATA_BITS = 44;
+    static const quint64 TAKEN_MASK = (Q_UINT64_C(1) << TAKEN_BITS) - 1;
+    static const quint64 DATA_MASK = (Q_UINT64_C(1) << DATA_BITS) - 1;
+
+    static quint32 key(quint64 hash) { return quint32(hash >> (64 - KEY_BITS)); }
+    // the key bits of a slot as stored
+    static quint32 storedKey(const Slot &s) { return quint32(s.data >> DATA_BITS) << 3 | quint32(s.taken >> TAKEN_BITS); }
+    // the fields besides the key folded into KEY_BITS bits
+    static quint32 check(const Slot &s);
+    // whether s is the entry of key, not torn by two threads writing it
+    static bool matches(const Slot &s, quint32 key) { return (storedKey(s) ^ check(s)) == key && (s.data >> 12 & USED); }
+    static Entry unpack(const Slot &s);
+    static Slot pack(const Entry &e, quint32 key);
+    int age(const Entry &e) const { return (_generation - (e.state >> GENERATION_SHIFT)) & GENERATION_MASK; }
+
+    Bucket *_buckets;
+    quint64 _mask;
+    int _generation;
+
+    QFile *_file;
+    FileHeader *_header;
+
+    Q_DISABLE_COPY(TranspositionTable)
+};
+
+#endif // TRANSPOSITIONTABLE_H